@@ -0,0 +1,175 @@
+// Checks and times the incremental analyzer against a full front-end pass.
+//
+//   g++ -std=c++17 -O2 -o incremental_bench Benchmarks/incremental_bench.cpp
+//   ./incremental_bench [functions]
+//
+// A generated program of short call chains is edited the way a user would:
+// a function body, a function's purity, a signature and a global's type.
+// After every edit the units the analyzer re-checked are compared against
+// the ones the edit can affect, and its error count and per-function purity
+// against a fresh ScopeAnalyzer + TypeChecker run. Exits nonzero on any
+// mismatch.
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../regex_lexer.hpp"
+#include "../parser.hpp"
+#include "../scope_analyzer.hpp"
+#include "../type_checker.hpp"
+#include "../incremental_analyzer.hpp"
+
+using namespace std;
+
+// Units of the program: the global, the functions f0..fn-1, the top level.
+// Every 8 functions form a call chain; the last of every other chain reads g.
+struct Source
+{
+  string global = "int g = 1 .";
+  vector<string> functions;
+  string top;
+
+  explicit Source(int n)
+  {
+    for (int i = 0; i < n; i++)
+      functions.push_back(function(i, i + 1, readsGlobal(i), false));
+    top = "int r = f" + to_string(n - 1) + "(3) .";
+  }
+
+  static string function(int i, int factor, bool readsGlobal, bool extraParam)
+  {
+    string name = "f" + to_string(i);
+    string text = "fn int " + name + "(int x" + (extraParam ? ", int z" : "") + ") { int y = x * " +
+                  to_string(factor) + " . wapsi y";
+    if (i % 8 != 0)
+      text += " + f" + to_string(i - 1) + "(x)";
+    if (readsGlobal)
+      text += " + g";
+    return text + " . } .";
+  }
+
+  static bool readsGlobal(int i) { return i % 16 == 15; }
+
+  string text() const
+  {
+    string out = global + "\n";
+    for (const auto &f : functions)
+      out += f + "\n";
+    return out + top + "\n";
+  }
+};
+
+struct Facts
+{
+  int errors = 0;
+  vector<bool> pure;
+};
+
+vector<Stmt *> parse(const string &source)
+{
+  Lexer lexer;
+  auto tokens = lexer.tokenize(source);
+  Parser parser(tokens);
+  return parser.parse();
+}
+
+Facts fullAnalysis(vector<Stmt *> &ast, int n)
+{
+  ScopeAnalyzer scopeAnalyzer;
+  for (auto stmt : ast)
+    scopeAnalyzer.analyze(stmt);
+  TypeChecker typeChecker;
+  typeChecker.check(ast, scopeAnalyzer.getGlobalScope());
+  Facts facts;
+  facts.errors = scopeAnalyzer.getErrorCount() + typeChecker.getErrorCount();
+  for (int i = 0; i < n; i++)
+    facts.pure.push_back(typeChecker.isPureFunction(Name("f" + to_string(i))));
+  return facts;
+}
+
+Facts incrementalFacts(IncrementalAnalyzer &analyzer, int n)
+{
+  Facts facts;
+  facts.errors = analyzer.getErrorCount();
+  for (int i = 0; i < n; i++)
+    facts.pure.push_back(analyzer.getTypeChecker()->isPureFunction(Name("f" + to_string(i))));
+  return facts;
+}
+
+int main(int argc, char **argv)
+{
+  int n = argc > 1 ? atoi(argv[1]) : 64;
+  n = max(n / 16, 1) * 16;
+
+  Source source(n);
+  int mid = n / 2;
+  vector<string> allUnits;
+  for (int i = 0; i < n; i++)
+    allUnits.push_back("f" + to_string(i));
+  allUnits.push_back("<toplevel>");
+  vector<string> readers;
+  for (int i = 0; i < n; i++)
+    if (Source::readsGlobal(i))
+      readers.push_back("f" + to_string(i));
+  readers.push_back("<toplevel>");
+
+  struct Step
+  {
+    string name;
+    function<void(Source &)> edit;
+    vector<string> expected;
+  };
+  vector<Step> steps = {
+      {"initial", [](Source &) {}, allUnits},
+      {"body", [&](Source &s) { s.functions[mid] = Source::function(mid, 100, false, false); },
+       {"f" + to_string(mid)}},
+      {"purity", [&](Source &s) { s.functions[3] = Source::function(3, 4, true, false); }, {"f3"}},
+      {"purity-back", [&](Source &s) { s.functions[3] = Source::function(3, 4, false, false); }, {"f3"}},
+      {"signature", [&](Source &s) { s.functions[8] = Source::function(8, 9, false, true); }, {"f8", "f9"}},
+      {"global-type", [](Source &s) { s.global = "float g = 1.0 ."; }, readers},
+  };
+  // Scope and type errors go to cerr; the ones the edits provoke are expected.
+  ostringstream diagnostics;
+  streambuf *savedCerr = cerr.rdbuf(diagnostics.rdbuf());
+
+  IncrementalAnalyzer analyzer;
+  bool ok = true;
+  cout << left << setw(14) << "edit" << right << setw(10) << "rechecked" << setw(8) << "errors"
+       << setw(8) << "pure" << setw(12) << "full us" << setw(12) << "incr us" << "  check" << endl;
+  for (auto &step : steps)
+  {
+    step.edit(source);
+    auto ast = parse(source.text());
+
+    auto t0 = chrono::steady_clock::now();
+    Facts full = fullAnalysis(ast, n);
+    auto t1 = chrono::steady_clock::now();
+    analyzer.update(ast);
+    auto t2 = chrono::steady_clock::now();
+    Facts incremental = incrementalFacts(analyzer, n);
+
+    set<string> rechecked, expected(step.expected.begin(), step.expected.end());
+    for (auto name : analyzer.getRechecked())
+      rechecked.insert(name.str());
+    bool same = rechecked == expected && full.errors == incremental.errors && full.pure == incremental.pure;
+    ok = ok && same;
+
+    int pure = 0;
+    for (bool p : incremental.pure)
+      pure += p;
+    cout << left << setw(14) << step.name << right << setw(10) << rechecked.size() << setw(8)
+         << incremental.errors << setw(8) << pure << setw(12)
+         << chrono::duration_cast<chrono::microseconds>(t1 - t0).count() << setw(12)
+         << chrono::duration_cast<chrono::microseconds>(t2 - t1).count() << "  "
+         << (same ? "ok" : "MISMATCH") << endl;
+  }
+
+  cerr.rdbuf(savedCerr);
+  return ok ? 0 : 1;
+}
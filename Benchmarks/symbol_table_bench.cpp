@@ -0,0 +1,92 @@
+// Stress benchmark for the global symbol table under concurrent analysis.
+//
+//   g++ -std=c++17 -O2 -pthread -o symbol_table_bench Benchmarks/symbol_table_bench.cpp
+//   ./symbol_table_bench [ops-per-thread]
+//
+// Every thread runs a front-end-like mix: 1 insert of a name it owns for
+// every 9 lookups of names drawn from the whole program. The sharded table
+// is compared against an unordered_map behind a single mutex.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../Utilities/concurrent_symbol_table.hpp"
+
+using namespace std;
+
+struct LockedTable
+{
+  mutex lock;
+  unordered_map<Name, int> map;
+
+  bool insert(Name name, int value)
+  {
+    lock_guard<mutex> guard(lock);
+    return map.emplace(name, value).second;
+  }
+
+  int *find(Name name)
+  {
+    lock_guard<mutex> guard(lock);
+    auto it = map.find(name);
+    return it == map.end() ? nullptr : &it->second;
+  }
+};
+
+template <typename Table>
+double run(int threads, size_t opsPerThread, const vector<Name> &names)
+{
+  Table table;
+  size_t namesPerThread = names.size() / 64;
+  atomic<size_t> hits{0};
+
+  auto worker = [&](int id)
+  {
+    mt19937 rng(id);
+    uniform_int_distribution<size_t> pick(0, names.size() - 1);
+    size_t own = id * namesPerThread, found = 0;
+    for (size_t i = 0; i < opsPerThread; i++)
+    {
+      if (i % 10 == 0)
+        table.insert(names[own + (i / 10) % namesPerThread], id);
+      else if (table.find(names[pick(rng)]))
+        found++;
+    }
+    hits += found;
+  };
+
+  auto start = chrono::steady_clock::now();
+  vector<thread> pool;
+  for (int t = 0; t < threads; t++)
+    pool.emplace_back(worker, t);
+  for (auto &t : pool)
+    t.join();
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+  return threads * opsPerThread / elapsed.count() / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+  size_t opsPerThread = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+  // The interner is filled up front, as the lexer does before analysis starts.
+  vector<Name> names;
+  for (int i = 0; i < 64 * 4096; i++)
+    names.push_back(Name("sym" + to_string(i)));
+
+  cout << "threads  sharded(Mops/s)  mutex+map(Mops/s)" << endl;
+  for (int threads = 1; threads <= 64; threads *= 2)
+  {
+    double sharded = run<ConcurrentSymbolTable<int>>(threads, opsPerThread, names);
+    double locked = run<LockedTable>(threads, opsPerThread, names);
+    cout << setw(7) << threads << setw(17) << fixed << setprecision(1) << sharded
+         << setw(19) << locked << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,326 @@
+// Measures the TAC optimizer on a few loop-heavy programs.
+//
+//   g++ -std=c++17 -O2 -I. -o tac_opt_bench Benchmarks/tac_opt_bench.cpp
+//       ir_generator.cpp cfg.cpp ssa.cpp sccp.cpp gvn.cpp dce.cpp licm.cpp
+//       strength_reduction.cpp simplify_cfg.cpp call_graph.cpp inliner.cpp
+//       tail_calls.cpp unroll.cpp ipcp.cpp tac_io.cpp def_use.cpp profile.cpp
+//   ./tac_opt_bench [runs]
+//
+// Each program is lowered to TAC, run through a growing prefix of the pass
+// list (whole-program passes first, then per-function passes between SSA
+// construction and destruction), and executed by a small TAC interpreter. The table
+// reports static quad count, quads executed, and interpreter time per run.
+// Every stage must return what the unoptimized TAC returns; the program
+// exits nonzero otherwise.
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "../regex_lexer.hpp"
+#include "../parser.hpp"
+#include "../ir_generator.hpp"
+#include "../cfg.hpp"
+#include "../ssa.hpp"
+#include "../sccp.hpp"
+#include "../gvn.hpp"
+#include "../dce.hpp"
+#include "../licm.hpp"
+#include "../strength_reduction.hpp"
+#include "../simplify_cfg.hpp"
+#include "../inliner.hpp"
+#include "../tail_calls.hpp"
+#include "../unroll.hpp"
+#include "../ipcp.hpp"
+
+using namespace std;
+
+struct BenchProgram
+{
+  const char *name;
+  const char *source;
+};
+
+static const BenchProgram programs[] = {
+    {"strided-sum",
+     "int n = 2000 . int stride = 4 . int s = 0 . int i = 0 ."
+     "jab (i < n) { s = s + i * stride . i = i + 1 . }"
+     "wapsi s ."},
+    {"flagged-nest",
+     "int debug = 0 . int rows = 60 . int cols = 60 . int s = 0 . int r = 0 ."
+     "jab (r < rows) { int c = 0 ."
+     "  jab (c < cols) { agar (debug == 1) { s = s - 1 . } warna { s = s + r * cols + c . } c = c + 1 . }"
+     "  r = r + 1 . }"
+     "wapsi s ."},
+    {"collatz",
+     "int best = 0 . int seed = 1 . int limit = 300 ."
+     "jab (seed < limit) { int x = seed . int steps = 0 ."
+     "  jab (x != 1) { agar (x % 2 == 0) { x = x / 2 . } warna { x = 3 * x + 1 . } steps = steps + 1 . }"
+     "  agar (steps > best) { best = steps . } seed = seed + 1 . }"
+     "wapsi best ."},
+    {"accessors",
+     "int bias = 1 ."
+     "fn int at(int base, int i) { wapsi base * 64 + i . } ."
+     "fn int clamp(int v, int hi) { agar (v > hi) { wapsi hi . } wapsi v . } ."
+     "fn int cell(int r, int c) { wapsi clamp(at(r, c), 2000) + bias . } ."
+     "int s = 0 . int r = 0 ."
+     "jab (r < 40) { int c = 0 . jab (c < 40) { s = s + cell(r, c) . c = c + 1 . } r = r + 1 . }"
+     "wapsi s ."},
+    {"tail-sum",
+     "fn int sum(int n, int acc) { agar (n == 0) { wapsi acc . } wapsi sum(n - 1, acc + n) . } ."
+     "int s = 0 . int k = 0 ."
+     "jab (k < 20) { s = s + sum(1000 + k, k) . k = k + 1 . }"
+     "wapsi s ."},
+    {"flag-walk",
+     "fn int walk(int n, int mode, int acc) { agar (n == 0) { wapsi acc . }"
+     "  agar (mode == 1) { wapsi walk(n - 1, mode, acc + n * 2) . } warna { wapsi walk(n - 1, mode, acc - n) . } } ."
+     "fn int unused(int q) { wapsi walk(q, q, q) . } ."
+     "int s = 0 . int k = 0 ."
+     "jab (k < 50) { s = s + walk(200, 1, k) - walk(100, 0, k) . k = k + 1 . }"
+     "wapsi s ."},
+    {"break-flag",
+     "int x . int i = 0 . jab (i < 3) { agar (x == 0) { toro . } x = 1 . i = i + 1 . } wapsi i ."},
+};
+
+// Just enough of a machine to run TAC programs: ints wrap at 64 bits,
+// mixed int/float arithmetic promotes, as in the language, and every call
+// gets a fresh frame.
+class TACMachine
+{
+  struct Value
+  {
+    bool isFloat = false;
+    int64_t i = 0;
+    double d = 0;
+  };
+
+  struct Frame
+  {
+    unordered_map<uint32_t, Value> env;
+    vector<Value> args;
+
+    Value read(Operand operand)
+    {
+      Value value;
+      switch (operand.kind())
+      {
+      case OperandKind::Int:
+        value.i = operand.intValue();
+        return value;
+      case OperandKind::Float:
+        value.isFloat = true;
+        value.d = operand.floatValue();
+        return value;
+      case OperandKind::Bool:
+        value.i = operand.boolValue();
+        return value;
+      default:
+        return env[operand.bits];
+      }
+    }
+  };
+
+  const TACProgram *program = nullptr;
+  unordered_map<uint32_t, Value> globals;
+  unordered_map<const TACFunction *, unordered_map<uint32_t, size_t>> labels;
+
+  static Operand constant(const Value &value)
+  {
+    return value.isFloat ? Operand::floatConst(value.d) : Operand::intConst(value.i);
+  }
+
+  Value call(const TACFunction &function, vector<Value> args)
+  {
+    auto &labelAt = labels[&function];
+    const auto &quads = function.quads;
+    if (labelAt.empty())
+      for (size_t i = 0; i < quads.size(); i++)
+        if (quads[i].op == Op::Label)
+          labelAt[quads[i].result.bits] = i;
+
+    Frame frame;
+    vector<Value> pending;
+    size_t pc = 0;
+    while (pc < quads.size())
+    {
+      const Quad &quad = quads[pc++];
+      if (++executed > stepLimit)
+        throw runtime_error("no result after " + to_string(stepLimit) + " quads");
+      switch (quad.op)
+      {
+      case Op::Label:
+        executed--;
+        break;
+      case Op::Goto:
+        pc = labelAt.at(quad.result.bits);
+        break;
+      case Op::IfFalse:
+      {
+        Value cond = frame.read(quad.arg1);
+        if (cond.isFloat ? cond.d == 0 : cond.i == 0)
+          pc = labelAt.at(quad.result.bits);
+        break;
+      }
+      case Op::Param:
+        frame.env[quad.result.bits] = args.at(quad.arg1.intValue());
+        break;
+      case Op::Arg:
+        pending.push_back(frame.read(quad.arg1));
+        break;
+      case Op::Call:
+      case Op::TailCall:
+      {
+        const TACFunction *callee = const_cast<TACProgram *>(program)->find(quad.arg1.name());
+        if (!callee)
+          throw runtime_error("call to unknown function " + quad.arg1.toString());
+        frame.env[quad.result.bits] = call(*callee, move(pending));
+        pending.clear();
+        break;
+      }
+      case Op::Load:
+        frame.env[quad.result.bits] = globals[quad.arg1.bits];
+        break;
+      case Op::Store:
+        globals[quad.result.bits] = frame.read(quad.arg1);
+        break;
+      case Op::Return:
+        return frame.read(quad.arg1);
+      default:
+      {
+        Operand folded;
+        Operand a = constant(frame.read(quad.arg1));
+        Operand b = isBinaryOp(quad.op) ? constant(frame.read(quad.arg2)) : a;
+        if (quad.op == Op::Not || quad.op == Op::And || quad.op == Op::Or)
+        {
+          a = Operand::boolConst(frame.read(quad.arg1).i != 0);
+          b = isBinaryOp(quad.op) ? Operand::boolConst(frame.read(quad.arg2).i != 0) : a;
+        }
+        if (!evaluateOp(quad.op, a, b, folded))
+          throw runtime_error("cannot execute " + quad.toString());
+        Value result;
+        if (folded.kind() == OperandKind::Float)
+        {
+          result.isFloat = true;
+          result.d = folded.floatValue();
+        }
+        else
+        {
+          result.i = folded.kind() == OperandKind::Bool ? folded.boolValue() : folded.intValue();
+        }
+        frame.env[quad.result.bits] = result;
+      }
+      }
+    }
+    return Value();
+  }
+
+public:
+  static const long stepLimit = 100000000;
+  long executed = 0;
+
+  string run(const TACProgram &code)
+  {
+    program = &code;
+    globals.clear();
+    labels.clear();
+    executed = 0;
+    Value result = call(*const_cast<TACProgram &>(code).find(Name("main")), {});
+    return result.isFloat ? to_string(result.d) : to_string(result.i);
+  }
+};
+
+static size_t quadCount(const TACProgram &program)
+{
+  size_t count = 0;
+  for (const auto &function : program.functions)
+    count += function.quads.size();
+  return count;
+}
+
+int main(int argc, char **argv)
+{
+  int runs = argc > 1 ? atoi(argv[1]) : 20;
+
+  // Stage k applies the first k passes; whole-program passes come first.
+  vector<pair<string, function<void(TACProgram &)>>> programPasses = {
+      {"tce", [](TACProgram &program) { TailCallEliminator().eliminateRecursion(program); }},
+      {"inline", [](TACProgram &program) { Inliner().run(program); }},
+      {"ipcp", [](TACProgram &program) { IPCP().run(program); }},
+      {"unroll", [](TACProgram &program) { LoopUnroller().run(program); }},
+  };
+  vector<pair<string, function<void(CFG &)>>> passes = {
+      {"sccp", [](CFG &cfg) { SCCP().run(cfg); }},
+      {"gvn", [](CFG &cfg) { GVN().run(cfg); }},
+      {"licm", [](CFG &cfg) { LoopInvariantCodeMotion().run(cfg); }},
+      {"sr", [](CFG &cfg) { StrengthReducer().run(cfg); }},
+      {"dce", [](CFG &cfg) { DeadCodeEliminator().run(cfg); }},
+      {"simplify", [](CFG &cfg) { CFGSimplifier().run(cfg); }},
+  };
+
+  cout << left << setw(14) << "program" << setw(10) << "stage" << right << setw(8) << "quads"
+       << setw(12) << "executed" << setw(12) << "us/run" << "  result" << endl;
+  bool ok = true;
+  for (const auto &program : programs)
+  {
+    Lexer lexer;
+    auto tokens = lexer.tokenize(program.source);
+    Parser parser(tokens);
+    auto ast = parser.parse();
+    IRGenerator irGenerator;
+    TACProgram tac = irGenerator.generate(ast);
+
+    string expected;
+    auto report = [&](const string &stage, const TACProgram &code)
+    {
+      TACMachine machine;
+      string result;
+      auto start = chrono::steady_clock::now();
+      try
+      {
+        for (int r = 0; r < runs; r++)
+          result = machine.run(code);
+      }
+      catch (const runtime_error &error)
+      {
+        result = error.what();
+      }
+      chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+      if (stage == "tac")
+        expected = result;
+      bool same = result == expected;
+      ok = ok && same;
+      cout << left << setw(14) << (stage == "tac" ? program.name : "") << setw(10) << stage << right
+           << setw(8) << quadCount(code) << setw(12) << machine.executed << setw(12) << fixed
+           << setprecision(1) << elapsed.count() / runs << "  " << result
+           << (same ? "" : "  MISMATCH, expected " + expected) << endl;
+    };
+
+    report("tac", tac);
+    size_t stageCount = programPasses.size() + passes.size();
+    for (size_t stage = 0; stage <= stageCount; stage++)
+    {
+      TACProgram code = tac;
+      for (size_t p = 0; p < min(stage, programPasses.size()); p++)
+        programPasses[p].second(code);
+      for (auto &function : code.functions)
+      {
+        CFG cfg = CFG::build(function.quads);
+        SSABuilder ssa;
+        ssa.construct(cfg);
+        for (size_t p = programPasses.size(); p < stage; p++)
+          passes[p - programPasses.size()].second(cfg);
+        ssa.destruct(cfg);
+        function.quads = cfg.linearize();
+      }
+      string name = stage == 0 ? "ssa"
+                    : stage <= programPasses.size() ? "+" + programPasses[stage - 1].first
+                                                    : "+" + passes[stage - 1 - programPasses.size()].first;
+      report(name, code);
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+#ifndef CONCURRENT_SYMBOL_TABLE_HPP
+#define CONCURRENT_SYMBOL_TABLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "symbol_interner.hpp"
+
+/**
+ * @brief Map from interned Name to V, safe for concurrent use. Entries are
+ * never removed, and values are immutable once published.
+ *
+ * Names are dense ids, so each shard (id % SHARD_COUNT) is a segmented
+ * array indexed by id / SHARD_COUNT. Segment k holds FIRST_SEGMENT << k
+ * slots and is never moved once published, so:
+ *  - find() takes no lock: two acquire loads (segment, slot) per lookup;
+ *  - insert() and assign() take only their shard's mutex, and never block
+ *    readers. assign() publishes a new copy and keeps the old one alive;
+ *  - returned pointers stay valid until clear() or destruction, and keep
+ *    showing the value as it was when they were found.
+ * clear() must only run while no other thread uses the table.
+ */
+template <typename V>
+class ConcurrentSymbolTable
+{
+private:
+  static const size_t SHARD_COUNT = 64;
+  static const size_t FIRST_SEGMENT = 16;
+  static const size_t MAX_SEGMENTS = 28; // enough slots for every 32-bit id
+
+  struct Shard
+  {
+    std::mutex writeLock;
+    std::atomic<std::atomic<V *> *> segments[MAX_SEGMENTS];
+    std::vector<V *> retired; // replaced by assign(), still visible to readers
+
+    Shard()
+    {
+      for (auto &segment : segments)
+        segment.store(nullptr, std::memory_order_relaxed);
+    }
+  };
+
+  Shard shards[SHARD_COUNT];
+  std::atomic<size_t> count{0};
+
+  static size_t segmentSize(size_t segment) { return FIRST_SEGMENT << segment; }
+
+  // Maps a per-shard index to (segment, offset): segment k starts at FIRST_SEGMENT * (2^k - 1).
+  static void locate(size_t index, size_t &segment, size_t &offset)
+  {
+    size_t scaled = index / FIRST_SEGMENT + 1;
+    segment = 0;
+    while (scaled >>= 1)
+      segment++;
+    offset = index - FIRST_SEGMENT * ((size_t(1) << segment) - 1);
+  }
+
+  std::atomic<V *> *slotFor(Name name, bool create)
+  {
+    Shard &shard = shards[name.id % SHARD_COUNT];
+    size_t segment, offset;
+    locate(name.id / SHARD_COUNT, segment, offset);
+    std::atomic<V *> *slots = shard.segments[segment].load(std::memory_order_acquire);
+    if (!slots && create)
+    {
+      slots = new std::atomic<V *>[segmentSize(segment)];
+      for (size_t i = 0; i < segmentSize(segment); i++)
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      shard.segments[segment].store(slots, std::memory_order_release);
+    }
+    return slots ? &slots[offset] : nullptr;
+  }
+
+public:
+  ConcurrentSymbolTable() = default;
+  ConcurrentSymbolTable(const ConcurrentSymbolTable &) = delete;
+  ConcurrentSymbolTable &operator=(const ConcurrentSymbolTable &) = delete;
+  ~ConcurrentSymbolTable() { clear(); }
+
+  const V *find(Name name) const
+  {
+    const Shard &shard = shards[name.id % SHARD_COUNT];
+    size_t segment, offset;
+    locate(name.id / SHARD_COUNT, segment, offset);
+    std::atomic<V *> *slots = shard.segments[segment].load(std::memory_order_acquire);
+    if (!slots)
+      return nullptr;
+    return slots[offset].load(std::memory_order_acquire);
+  }
+
+  bool contains(Name name) const { return find(name) != nullptr; }
+
+  // Inserts unless the name is already present; returns whether it inserted.
+  bool insert(Name name, const V &value)
+  {
+    Shard &shard = shards[name.id % SHARD_COUNT];
+    std::lock_guard<std::mutex> guard(shard.writeLock);
+    std::atomic<V *> *slot = slotFor(name, true);
+    if (slot->load(std::memory_order_relaxed))
+      return false;
+    slot->store(new V(value), std::memory_order_release);
+    count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Inserts or replaces the value; returns whether the name was new.
+  bool assign(Name name, const V &value)
+  {
+    Shard &shard = shards[name.id % SHARD_COUNT];
+    std::lock_guard<std::mutex> guard(shard.writeLock);
+    std::atomic<V *> *slot = slotFor(name, true);
+    V *old = slot->exchange(new V(value), std::memory_order_acq_rel);
+    if (!old)
+    {
+      count.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    shard.retired.push_back(old);
+    return false;
+  }
+
+  size_t size() const { return count.load(std::memory_order_relaxed); }
+
+  void clear()
+  {
+    for (auto &shard : shards)
+    {
+      for (V *value : shard.retired)
+        delete value;
+      shard.retired.clear();
+      for (size_t segment = 0; segment < MAX_SEGMENTS; segment++)
+      {
+        std::atomic<V *> *slots = shard.segments[segment].load(std::memory_order_acquire);
+        if (!slots)
+          continue;
+        for (size_t i = 0; i < segmentSize(segment); i++)
+          delete slots[i].load(std::memory_order_relaxed);
+        delete[] slots;
+        shard.segments[segment].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+    count.store(0, std::memory_order_relaxed);
+  }
+};
+
+#endif
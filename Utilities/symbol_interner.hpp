@@ -0,0 +1,89 @@
+#ifndef SYMBOL_INTERNER_HPP
+#define SYMBOL_INTERNER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+typedef uint32_t SymbolId;
+
+/**
+ * @brief Process-wide table mapping every distinct identifier spelling to a
+ * dense 32-bit id. Id 0 is always the empty string. Spellings live in a
+ * deque so references handed out by spelling() stay valid as it grows.
+ */
+class SymbolInterner
+{
+private:
+  std::deque<std::string> spellings;
+  std::unordered_map<std::string, SymbolId> ids;
+
+  SymbolInterner() { intern(""); }
+
+public:
+  static SymbolInterner &instance()
+  {
+    static SymbolInterner interner;
+    return interner;
+  }
+
+  SymbolId intern(const std::string &spelling)
+  {
+    auto it = ids.find(spelling);
+    if (it != ids.end())
+      return it->second;
+    SymbolId id = static_cast<SymbolId>(spellings.size());
+    spellings.push_back(spelling);
+    ids.emplace(spelling, id);
+    return id;
+  }
+
+  const std::string &spelling(SymbolId id) const { return spellings[id]; }
+
+  size_t size() const { return spellings.size(); }
+};
+
+/**
+ * @brief An interned identifier. Compared and hashed by id; the spelling is
+ * only looked up when printing.
+ */
+struct Name
+{
+  SymbolId id;
+
+  Name() : id(0) {}
+  explicit Name(const std::string &spelling) : id(SymbolInterner::instance().intern(spelling)) {}
+  explicit Name(const char *spelling) : Name(std::string(spelling)) {}
+  static Name fromId(SymbolId id)
+  {
+    Name n;
+    n.id = id;
+    return n;
+  }
+
+  const std::string &str() const { return SymbolInterner::instance().spelling(id); }
+  bool empty() const { return id == 0; }
+
+  bool operator==(const Name &other) const { return id == other.id; }
+  bool operator!=(const Name &other) const { return id != other.id; }
+  bool operator<(const Name &other) const { return id < other.id; }
+};
+
+inline std::ostream &operator<<(std::ostream &out, const Name &name)
+{
+  return out << name.str();
+}
+
+namespace std
+{
+  template <>
+  struct hash<Name>
+  {
+    size_t operator()(const Name &name) const { return name.id; }
+  };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define TOKEN_TYPES_HPP
 
 #include <string>
+#include "symbol_interner.hpp"
 
 enum TokenType
 {
@@ -71,12 +72,20 @@ enum TokenType
 struct Token
 {
   TokenType type;
-  std::string value;
+  std::string value; // lexeme of literals, keywords and operators
+  Name name;         // interned spelling of identifiers
   int line;
   int column;
 
   Token(TokenType t = T_UNKNOWN_RL, const std::string &v = "", int l = 1, int c = 1)
       : type(t), value(v), line(l), column(c) {}
+  Token(TokenType t, Name n, int l, int c)
+      : type(t), name(n), line(l), column(c) {}
+
+  const std::string &text() const
+  {
+    return type == T_IDENTIFIER_RL ? name.str() : value;
+  }
 };
 
 #endif
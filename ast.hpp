@@ -1,9 +1,11 @@
 #ifndef SIMPLE_AST_HPP
 #define SIMPLE_AST_HPP
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "Utilities/token_types.hpp"
+#include "Utilities/symbol_interner.hpp"
 
 using namespace std;
 
@@ -46,8 +48,8 @@ public:
 class IntLiteral : public Expr
 {
 public:
-  int value;
-  IntLiteral(int v) : value(v) { nodeType = NODE_INT_LIT; }
+  int64_t value;
+  IntLiteral(int64_t v) : value(v) { nodeType = NODE_INT_LIT; }
 };
 
 class FloatLiteral : public Expr
@@ -74,8 +76,8 @@ public:
 class Identifier : public Expr
 {
 public:
-  string name;
-  Identifier(string n) : name(n) { nodeType = NODE_IDENTIFIER; }
+  Name name;
+  Identifier(Name n) : name(n) { nodeType = NODE_IDENTIFIER; }
 };
 
 class BinaryOp : public Expr
@@ -110,9 +112,9 @@ public:
 class Assignment : public Expr
 {
 public:
-  string ident;
+  Name ident;
   Expr *value;
-  Assignment(string i, Expr *v) : ident(i), value(v)
+  Assignment(Name i, Expr *v) : ident(i), value(v)
   {
     nodeType = NODE_ASSIGNMENT;
   }
@@ -122,9 +124,9 @@ public:
 class FunctionCall : public Expr
 {
 public:
-  string name;
+  Name name;
   vector<Expr *> args;
-  FunctionCall(string n) : name(n) { nodeType = NODE_FUNC_CALL; }
+  FunctionCall(Name n) : name(n) { nodeType = NODE_FUNC_CALL; }
   ~FunctionCall()
   {
     for (auto arg : args)
@@ -142,9 +144,9 @@ class VarDecl : public Stmt
 {
 public:
   TokenType type;
-  string ident;
+  Name ident;
   Expr *expr;
-  VarDecl(TokenType t, string i, Expr *e = nullptr)
+  VarDecl(TokenType t, Name i, Expr *e = nullptr)
       : type(t), ident(i), expr(e)
   {
     nodeType = NODE_VAR_DECL;
@@ -251,18 +253,18 @@ public:
 struct Param
 {
   TokenType type;
-  string name;
-  Param(TokenType t, string n) : type(t), name(n) {}
+  Name name;
+  Param(TokenType t, Name n) : type(t), name(n) {}
 };
 
 class FunctionDecl : public Stmt
 {
 public:
   TokenType returnType;
-  string name;
+  Name name;
   vector<Param> params;
   Stmt *body;
-  FunctionDecl(TokenType rt, string n, vector<Param> p, Stmt *b)
+  FunctionDecl(TokenType rt, Name n, vector<Param> p, Stmt *b)
       : returnType(rt), name(n), params(p), body(b)
   {
     nodeType = NODE_FUNC_DECL;
@@ -0,0 +1,339 @@
+#ifndef AST_INTERPRETER_HPP
+#define AST_INTERPRETER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Utilities/token_types.hpp"
+#include "ast.hpp"
+
+using namespace std;
+
+/**
+ * @brief A compile-time value: an int, float or bool literal.
+ */
+struct ConstValue {
+    TokenType type;
+    int64_t intValue;
+    double floatValue;
+    bool boolValue;
+
+    ConstValue() : type(T_UNKNOWN_RL), intValue(0), floatValue(0.0), boolValue(false) {}
+
+    static ConstValue ofInt(int64_t v) { ConstValue c; c.type = T_INT_RL; c.intValue = v; return c; }
+    static ConstValue ofFloat(double v) { ConstValue c; c.type = T_FLOAT_RL; c.floatValue = v; return c; }
+    static ConstValue ofBool(bool v) { ConstValue c; c.type = T_BOOL_RL; c.boolValue = v; return c; }
+
+    static bool fromLiteral(Expr* expr, ConstValue& out) {
+        if (!expr) return false;
+        switch (expr->nodeType) {
+            case NODE_INT_LIT: out = ofInt(static_cast<IntLiteral*>(expr)->value); return true;
+            case NODE_FLOAT_LIT: out = ofFloat(static_cast<FloatLiteral*>(expr)->value); return true;
+            case NODE_BOOL_LIT: out = ofBool(static_cast<BoolLiteral*>(expr)->value); return true;
+            default: return false;
+        }
+    }
+
+    Expr* toLiteral() const {
+        switch (type) {
+            case T_INT_RL: return new IntLiteral(intValue);
+            case T_FLOAT_RL: return new FloatLiteral(floatValue);
+            case T_BOOL_RL: return new BoolLiteral(boolValue);
+            default: return nullptr;
+        }
+    }
+
+    double asDouble() const { return type == T_FLOAT_RL ? floatValue : intValue; }
+};
+
+/**
+ * @brief Evaluates calls to side-effect-free functions at compile time.
+ *
+ * Uses the language's run-time semantics (wrapping 64-bit ints, int to
+ * float promotion). Evaluation gives up, leaving the call in place, when
+ * the step budget or recursion limit runs out, on division by zero, or on
+ * anything that is not an int/float/bool computation.
+ */
+class ASTInterpreter {
+private:
+    enum class Flow { Normal, Break, Continue, Return, Abort };
+
+    const unordered_map<Name, FunctionDecl*>& functions;
+    vector<unordered_map<Name, ConstValue>> scopes;
+    ConstValue returnValue;
+    long stepsLeft;
+    int depth = 0;
+
+    static const int MAX_DEPTH = 256;
+
+    static int64_t wrap(uint64_t value) {
+        return static_cast<int64_t>(value);
+    }
+
+    bool step() {
+        return --stepsLeft >= 0;
+    }
+
+    ConstValue* lookup(Name name) {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) return &found->second;
+        }
+        return nullptr;
+    }
+
+    static ConstValue convert(const ConstValue& value, TokenType type) {
+        if (type == T_GINTI_RL) type = T_INT_RL;
+        if (type == T_FLOAT_RL && value.type == T_INT_RL) return ConstValue::ofFloat(value.intValue);
+        return value;
+    }
+
+    bool evalBinary(TokenType op, const ConstValue& l, const ConstValue& r, ConstValue& out) {
+        if (l.type == T_BOOL_RL && r.type == T_BOOL_RL) {
+            switch (op) {
+                case T_AND_LOGICAL_RL: out = ConstValue::ofBool(l.boolValue && r.boolValue); return true;
+                case T_OR_LOGICAL_RL: out = ConstValue::ofBool(l.boolValue || r.boolValue); return true;
+                case T_EQUALSOP_RL: out = ConstValue::ofBool(l.boolValue == r.boolValue); return true;
+                case T_NOT_EQUALS_RL: out = ConstValue::ofBool(l.boolValue != r.boolValue); return true;
+                default: return false;
+            }
+        }
+        if (l.type == T_INT_RL && r.type == T_INT_RL) {
+            int64_t a = l.intValue, b = r.intValue;
+            switch (op) {
+                case T_PLUS_RL: out = ConstValue::ofInt(wrap(static_cast<uint64_t>(a) + b)); return true;
+                case T_MINUS_RL: out = ConstValue::ofInt(wrap(static_cast<uint64_t>(a) - b)); return true;
+                case T_MUL_RL: out = ConstValue::ofInt(wrap(static_cast<uint64_t>(a) * b)); return true;
+                case T_DIV_RL:
+                    if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+                    out = ConstValue::ofInt(a / b); return true;
+                case T_MOD_RL:
+                    if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+                    out = ConstValue::ofInt(a % b); return true;
+                case T_AND_BIT_RL: out = ConstValue::ofInt(a & b); return true;
+                case T_OR_BIT_RL: out = ConstValue::ofInt(a | b); return true;
+                case T_XOR_BIT_RL: out = ConstValue::ofInt(a ^ b); return true;
+                case T_EQUALSOP_RL: out = ConstValue::ofBool(a == b); return true;
+                case T_NOT_EQUALS_RL: out = ConstValue::ofBool(a != b); return true;
+                case T_LESS_THAN_RL: out = ConstValue::ofBool(a < b); return true;
+                case T_GREATER_THAN_RL: out = ConstValue::ofBool(a > b); return true;
+                case T_LESS_EQUAL_RL: out = ConstValue::ofBool(a <= b); return true;
+                case T_GREATER_EQUAL_RL: out = ConstValue::ofBool(a >= b); return true;
+                default: return false;
+            }
+        }
+        if (l.type == T_BOOL_RL || r.type == T_BOOL_RL) return false;
+        double a = l.asDouble(), b = r.asDouble();
+        switch (op) {
+            case T_PLUS_RL: out = ConstValue::ofFloat(a + b); return true;
+            case T_MINUS_RL: out = ConstValue::ofFloat(a - b); return true;
+            case T_MUL_RL: out = ConstValue::ofFloat(a * b); return true;
+            case T_DIV_RL:
+                if (b == 0.0) return false;
+                out = ConstValue::ofFloat(a / b); return true;
+            case T_EQUALSOP_RL: out = ConstValue::ofBool(a == b); return true;
+            case T_NOT_EQUALS_RL: out = ConstValue::ofBool(a != b); return true;
+            case T_LESS_THAN_RL: out = ConstValue::ofBool(a < b); return true;
+            case T_GREATER_THAN_RL: out = ConstValue::ofBool(a > b); return true;
+            case T_LESS_EQUAL_RL: out = ConstValue::ofBool(a <= b); return true;
+            case T_GREATER_EQUAL_RL: out = ConstValue::ofBool(a >= b); return true;
+            default: return false;
+        }
+    }
+
+    bool evalExpression(Expr* expr, ConstValue& out) {
+        if (!expr || !step()) return false;
+
+        switch (expr->nodeType) {
+            case NODE_INT_LIT:
+            case NODE_FLOAT_LIT:
+            case NODE_BOOL_LIT:
+                return ConstValue::fromLiteral(expr, out);
+            case NODE_IDENTIFIER: {
+                ConstValue* value = lookup(static_cast<Identifier*>(expr)->name);
+                if (!value) return false;
+                out = *value;
+                return true;
+            }
+            case NODE_BINARY_OP: {
+                auto* bin = static_cast<BinaryOp*>(expr);
+                ConstValue l, r;
+                if (!evalExpression(bin->left, l)) return false;
+                // && and || skip their right side, as the generated code does.
+                bool logical = bin->op == T_AND_LOGICAL_RL || bin->op == T_OR_LOGICAL_RL;
+                if (logical && l.type == T_BOOL_RL && l.boolValue == (bin->op == T_OR_LOGICAL_RL)) {
+                    out = l;
+                    return true;
+                }
+                if (!evalExpression(bin->right, r)) return false;
+                return evalBinary(bin->op, l, r, out);
+            }
+            case NODE_UNARY_OP: {
+                auto* un = static_cast<UnaryOp*>(expr);
+                ConstValue operand;
+                if (!evalExpression(un->operand, operand)) return false;
+                if (un->op == T_MINUS_RL && operand.type == T_INT_RL) {
+                    out = ConstValue::ofInt(wrap(0 - static_cast<uint64_t>(operand.intValue)));
+                } else if (un->op == T_MINUS_RL && operand.type == T_FLOAT_RL) {
+                    out = ConstValue::ofFloat(-operand.floatValue);
+                } else if (un->op == T_NOT_RL && operand.type == T_BOOL_RL) {
+                    out = ConstValue::ofBool(!operand.boolValue);
+                } else {
+                    return false;
+                }
+                return true;
+            }
+            case NODE_ASSIGNMENT: {
+                auto* assign = static_cast<Assignment*>(expr);
+                ConstValue* target = lookup(assign->ident);
+                if (!target || !evalExpression(assign->value, out)) return false;
+                out = convert(out, target->type);
+                *target = out;
+                return true;
+            }
+            case NODE_FUNC_CALL: {
+                auto* call = static_cast<FunctionCall*>(expr);
+                vector<ConstValue> args;
+                for (auto arg : call->args) {
+                    ConstValue value;
+                    if (!evalExpression(arg, value)) return false;
+                    args.push_back(value);
+                }
+                return invoke(call->name, args, out);
+            }
+            default:
+                return false;
+        }
+    }
+
+    Flow evalStatement(Stmt* stmt) {
+        if (!stmt) return Flow::Normal;
+        if (!step()) return Flow::Abort;
+
+        switch (stmt->nodeType) {
+            case NODE_VAR_DECL: {
+                auto* decl = static_cast<VarDecl*>(stmt);
+                TokenType type = decl->type == T_GINTI_RL ? T_INT_RL : decl->type;
+                ConstValue value;
+                if (decl->expr) {
+                    if (!evalExpression(decl->expr, value)) return Flow::Abort;
+                    value = convert(value, type);
+                } else if (type == T_INT_RL) {
+                    value = ConstValue::ofInt(0);
+                } else if (type == T_FLOAT_RL) {
+                    value = ConstValue::ofFloat(0.0);
+                } else if (type == T_BOOL_RL) {
+                    value = ConstValue::ofBool(false);
+                } else {
+                    return Flow::Abort;
+                }
+                scopes.back()[decl->ident] = value;
+                return Flow::Normal;
+            }
+            case NODE_EXPR_STMT: {
+                ConstValue ignored;
+                return evalExpression(static_cast<ExprStmt*>(stmt)->expr, ignored) ? Flow::Normal : Flow::Abort;
+            }
+            case NODE_RETURN: {
+                auto* ret = static_cast<ReturnStmt*>(stmt);
+                if (!ret->expr || !evalExpression(ret->expr, returnValue)) return Flow::Abort;
+                return Flow::Return;
+            }
+            case NODE_BREAK:
+                return Flow::Break;
+            case NODE_CONTINUE:
+                return Flow::Continue;
+            case NODE_BLOCK: {
+                scopes.emplace_back();
+                Flow flow = Flow::Normal;
+                for (auto* s : static_cast<Block*>(stmt)->stmts) {
+                    flow = evalStatement(s);
+                    if (flow != Flow::Normal) break;
+                }
+                scopes.pop_back();
+                return flow;
+            }
+            case NODE_IF: {
+                auto* ifStmt = static_cast<IfStmt*>(stmt);
+                ConstValue cond;
+                if (!evalExpression(ifStmt->condition, cond) || cond.type != T_BOOL_RL) return Flow::Abort;
+                return evalStatement(cond.boolValue ? ifStmt->thenBranch : ifStmt->elseBranch);
+            }
+            case NODE_WHILE: {
+                auto* whileStmt = static_cast<WhileStmt*>(stmt);
+                while (true) {
+                    ConstValue cond;
+                    if (!evalExpression(whileStmt->condition, cond) || cond.type != T_BOOL_RL) return Flow::Abort;
+                    if (!cond.boolValue) return Flow::Normal;
+                    Flow flow = evalStatement(whileStmt->body);
+                    if (flow == Flow::Break) return Flow::Normal;
+                    if (flow == Flow::Return || flow == Flow::Abort) return flow;
+                }
+            }
+            case NODE_FOR: {
+                auto* forStmt = static_cast<ForStmt*>(stmt);
+                scopes.emplace_back();
+                Flow result = evalStatement(forStmt->init);
+                while (result == Flow::Normal) {
+                    if (forStmt->condition) {
+                        ConstValue cond;
+                        if (!evalExpression(forStmt->condition, cond) || cond.type != T_BOOL_RL) {
+                            result = Flow::Abort;
+                            break;
+                        }
+                        if (!cond.boolValue) break;
+                    }
+                    Flow flow = evalStatement(forStmt->body);
+                    if (flow == Flow::Break) break;
+                    if (flow == Flow::Return || flow == Flow::Abort) {
+                        result = flow;
+                        break;
+                    }
+                    ConstValue ignored;
+                    if (forStmt->update && !evalExpression(forStmt->update, ignored)) result = Flow::Abort;
+                }
+                scopes.pop_back();
+                return result;
+            }
+            default:
+                return Flow::Abort;
+        }
+    }
+
+    bool invoke(Name name, const vector<ConstValue>& args, ConstValue& out) {
+        auto it = functions.find(name);
+        if (it == functions.end() || depth >= MAX_DEPTH) return false;
+        FunctionDecl* func = it->second;
+        if (func->params.size() != args.size()) return false;
+
+        vector<unordered_map<Name, ConstValue>> saved;
+        saved.swap(scopes);
+        scopes.emplace_back();
+        for (size_t i = 0; i < args.size(); i++) {
+            scopes.back()[func->params[i].name] = convert(args[i], func->params[i].type);
+        }
+        depth++;
+        Flow flow = evalStatement(func->body);
+        depth--;
+        scopes.swap(saved);
+
+        if (flow != Flow::Return) return false;
+        out = convert(returnValue, func->returnType);
+        TokenType expected = func->returnType == T_GINTI_RL ? T_INT_RL : func->returnType;
+        return out.type == expected;
+    }
+
+public:
+    static const long DEFAULT_STEP_BUDGET = 100000;
+
+    ASTInterpreter(const unordered_map<Name, FunctionDecl*>& pureFunctions, long stepBudget = DEFAULT_STEP_BUDGET)
+        : functions(pureFunctions), stepsLeft(stepBudget) {}
+
+    // Evaluates name(args); returns false if the call cannot be done at compile time.
+    bool call(Name name, const vector<ConstValue>& args, ConstValue& out) {
+        return invoke(name, args, out);
+    }
+};
+
+#endif
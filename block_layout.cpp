@@ -0,0 +1,92 @@
+#include "block_layout.hpp"
+#include <algorithm>
+
+void BlockLayout::run(TACProgram& program) {
+    if (!profile || !profile->isLoaded()) return;
+    for (auto& function : program.functions) {
+        if (profile->covers(function.name) && layOut(function)) laidOutCount++;
+    }
+}
+
+bool BlockLayout::layOut(TACFunction& function) {
+    CFG cfg = CFG::build(function.quads);
+    const int n = static_cast<int>(cfg.blocks.size());
+    if (n < 3) return false;
+    vector<uint64_t> counts = profile->blockCounts(cfg, function.name);
+
+    struct Edge {
+        uint64_t weight;
+        int from, to;
+    };
+    vector<Edge> edges;
+    for (const auto& block : cfg.blocks) {
+        // TAC has no inverted if_false, so only its fallthrough edge can
+        // be laid out straight.
+        const Quad* term = block.terminator();
+        bool conditional = term && term->op == Op::IfFalse;
+        for (int s : block.succs) {
+            if (s == 0 || s == block.id || (conditional && s != block.id + 1)) continue;
+            edges.push_back({profile->edgeCount(cfg, counts, block.id, s), block.id, s});
+        }
+    }
+    stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.weight > b.weight; });
+
+    // A chain is named by its first block, which never changes.
+    vector<vector<int>> chains(n);
+    vector<int> chainOf(n);
+    for (int b = 0; b < n; b++) {
+        chains[b] = {b};
+        chainOf[b] = b;
+    }
+    // A block that runs off the end of the function has to stay last.
+    bool pinned = cfg.blocks.back().fallsThrough();
+    for (const auto& edge : edges) {
+        if (edge.weight == 0) break;
+        int head = chainOf[edge.from], tail = chainOf[edge.to];
+        if (head == tail || chains[head].back() != edge.from || chains[tail].front() != edge.to) continue;
+        if (pinned && edge.from == n - 1) continue;
+        for (int b : chains[tail]) chainOf[b] = head;
+        chains[head].insert(chains[head].end(), chains[tail].begin(), chains[tail].end());
+        chains[tail].clear();
+    }
+
+    vector<int> hot, cold;
+    for (int c = 1; c < n; c++) {
+        if (chains[c].empty() || (pinned && c == chainOf[n - 1])) continue;
+        bool ran = any_of(chains[c].begin(), chains[c].end(), [&](int b) { return counts[b] > 0; });
+        (ran ? hot : cold).push_back(c);
+    }
+    vector<int> order = chains[0];
+    for (const auto* group : {&hot, &cold}) {
+        for (int c : *group) order.insert(order.end(), chains[c].begin(), chains[c].end());
+    }
+    if (pinned && chainOf[n - 1] != 0) order.insert(order.end(), chains[chainOf[n - 1]].begin(), chains[chainOf[n - 1]].end());
+
+    int moved = 0;
+    for (int k = 0; k < n; k++) moved += order[k] != k;
+    if (!moved) return false;
+
+    vector<int> position(n);
+    for (int k = 0; k < n; k++) position[order[k]] = k;
+    auto followedBy = [&](int b, int next) { return position[b] + 1 < n && order[position[b] + 1] == next; };
+    for (int b = 0; b + 1 < n; b++) {
+        if (cfg.blocks[b].fallsThrough() && !followedBy(b, b + 1)) cfg.labelOf(b + 1);
+    }
+
+    vector<Quad> quads;
+    quads.reserve(function.quads.size() + n);
+    for (int k = 0; k < n; k++) {
+        const BasicBlock& block = cfg.blocks[order[k]];
+        int next = k + 1 < n ? order[k + 1] : -1;
+        if (!block.label.isNone()) quads.push_back(Quad(Op::Label, Operand(), Operand(), block.label));
+        const Quad* term = block.terminator();
+        bool jumpsToNext = term && term->op == Op::Goto && cfg.blockForLabel(term->result) == next;
+        quads.insert(quads.end(), block.quads.begin(), block.quads.end() - (jumpsToNext ? 1 : 0));
+        if (block.fallsThrough() && block.id + 1 < n && next != block.id + 1) {
+            quads.push_back(Quad(Op::Goto, Operand(), Operand(), cfg.blocks[block.id + 1].label));
+        }
+    }
+    function.quads = move(quads);
+    movedCount += moved;
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef BLOCK_LAYOUT_HPP
+#define BLOCK_LAYOUT_HPP
+
+#include <vector>
+#include "tac.hpp"
+#include "cfg.hpp"
+#include "profile.hpp"
+
+using namespace std;
+
+/**
+ * @brief Reorders the blocks of each function by profile so that hot
+ * paths fall through and blocks that never ran sit at the end.
+ *
+ * Edges are taken hottest first and glued into chains whenever the source
+ * still ends its chain and the target still starts one (Pettis and
+ * Hansen). The jump edge of an if_false is left out, as TAC cannot invert
+ * the branch to make it fall through. Chains keep the order of their
+ * first block, the entry's chain first, with chains that never ran moved
+ * last. Gotos to the next block are dropped and broken fallthroughs get a
+ * goto. Runs on TAC after the per-function passes; without a profile it
+ * changes nothing.
+ */
+class BlockLayout {
+private:
+    const EdgeProfile* profile;
+    int movedCount = 0;
+    int laidOutCount = 0;
+
+    bool layOut(TACFunction& function);
+
+public:
+    explicit BlockLayout(const EdgeProfile* profile) : profile(profile) {}
+
+    void run(TACProgram& program);
+
+    int getLaidOutFunctionCount() const { return laidOutCount; }
+    int getMovedBlockCount() const { return movedCount; }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "call_graph.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    // Tarjan's algorithm; components come out callees first.
+    struct ComponentFinder {
+        const vector<vector<int>>& edges;
+        vector<int> index, low, stack;
+        vector<bool> onStack;
+        int counter = 0;
+        vector<vector<int>> components;
+
+        explicit ComponentFinder(const vector<vector<int>>& e)
+            : edges(e), index(e.size(), -1), low(e.size(), 0), onStack(e.size(), false) {}
+
+        void visit(int v) {
+            index[v] = low[v] = counter++;
+            stack.push_back(v);
+            onStack[v] = true;
+            for (int w : edges[v]) {
+                if (index[w] < 0) {
+                    visit(w);
+                    low[v] = min(low[v], low[w]);
+                } else if (onStack[w]) {
+                    low[v] = min(low[v], index[w]);
+                }
+            }
+            if (low[v] != index[v]) return;
+            vector<int> component;
+            int w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                onStack[w] = false;
+                component.push_back(w);
+            } while (w != v);
+            sort(component.begin(), component.end());
+            components.push_back(component);
+        }
+    };
+}
+
+CallGraph CallGraph::build(const TACProgram& program) {
+    CallGraph graph;
+    size_t count = program.functions.size();
+    graph.callees.assign(count, {});
+    graph.callers.assign(count, {});
+
+    unordered_map<uint32_t, int> indexOf;
+    for (size_t f = 0; f < count; f++) indexOf[program.functions[f].name.id] = static_cast<int>(f);
+
+    for (size_t f = 0; f < count; f++) {
+        for (const auto& quad : program.functions[f].quads) {
+            if (!isCall(quad.op)) continue;
+            auto it = indexOf.find(quad.arg1.payload());
+            if (it == indexOf.end()) continue;
+            auto& callees = graph.callees[f];
+            if (find(callees.begin(), callees.end(), it->second) != callees.end()) continue;
+            callees.push_back(it->second);
+            graph.callers[it->second].push_back(static_cast<int>(f));
+        }
+    }
+
+    ComponentFinder finder(graph.callees);
+    for (size_t f = 0; f < count; f++) {
+        if (finder.index[f] < 0) finder.visit(static_cast<int>(f));
+    }
+    graph.components = move(finder.components);
+    graph.component.assign(count, -1);
+    for (size_t c = 0; c < graph.components.size(); c++) {
+        for (int f : graph.components[c]) graph.component[f] = static_cast<int>(c);
+    }
+    return graph;
+}
+
+bool CallGraph::isRecursive(int function) const {
+    if (components[component[function]].size() > 1) return true;
+    const auto& own = callees[function];
+    return find(own.begin(), own.end(), function) != own.end();
+}
+
+vector<bool> CallGraph::reachableFrom(int root) const {
+    vector<bool> reached(callees.size(), false);
+    vector<int> work = {root};
+    reached[root] = true;
+    while (!work.empty()) {
+        int f = work.back();
+        work.pop_back();
+        for (int callee : callees[f]) {
+            if (reached[callee]) continue;
+            reached[callee] = true;
+            work.push_back(callee);
+        }
+    }
+    return reached;
+}
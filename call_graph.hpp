@@ -0,0 +1,29 @@
+#ifndef CALL_GRAPH_HPP
+#define CALL_GRAPH_HPP
+
+#include <vector>
+#include "tac.hpp"
+
+using namespace std;
+
+/**
+ * @brief Who calls whom among a program's functions, by index into
+ * TACProgram::functions. Calls to functions the program does not define
+ * are left out.
+ */
+class CallGraph {
+public:
+    vector<vector<int>> callees;    // distinct, in order of first call
+    vector<vector<int>> callers;    // distinct
+    vector<int> component;          // strongly connected component of each function
+    vector<vector<int>> components; // callees' components before their callers'
+
+    static CallGraph build(const TACProgram& program);
+
+    // True if the function can reach a call to itself.
+    bool isRecursive(int function) const;
+    // Functions reachable from `root` through calls, `root` included.
+    vector<bool> reachableFrom(int root) const;
+};
+
+#endif
@@ -0,0 +1,400 @@
+#include "cfg.hpp"
+#include <algorithm>
+
+namespace {
+    void noteOperand(const Operand& operand, uint32_t& temps, uint32_t& labels) {
+        if (operand.isTemp()) temps = max(temps, operand.payload() + 1);
+        if (operand.isLabel()) labels = max(labels, operand.payload() + 1);
+    }
+
+    void addEdge(vector<BasicBlock>& blocks, int from, int to) {
+        auto& succs = blocks[from].succs;
+        if (find(succs.begin(), succs.end(), to) != succs.end()) return;
+        succs.push_back(to);
+        blocks[to].preds.push_back(from);
+    }
+}
+
+CFG CFG::build(const vector<Quad>& quads) {
+    CFG cfg;
+    cfg.blocks.emplace_back(0);
+    int current = 0;
+
+    for (const auto& quad : quads) {
+        noteOperand(quad.arg1, cfg.tempCount, cfg.labelCount);
+        noteOperand(quad.arg2, cfg.tempCount, cfg.labelCount);
+        noteOperand(quad.result, cfg.tempCount, cfg.labelCount);
+
+        if (quad.op == Op::Label) {
+            // The entry block stays unlabeled so nothing can jump back to it.
+            BasicBlock* open = current >= 0 ? &cfg.blocks[current] : nullptr;
+            if (!open || current == 0 || !open->quads.empty() || !open->label.isNone()) {
+                current = static_cast<int>(cfg.blocks.size());
+                cfg.blocks.emplace_back(current);
+            }
+            cfg.blocks[current].label = quad.result;
+            continue;
+        }
+
+        if (current < 0) {
+            current = static_cast<int>(cfg.blocks.size());
+            cfg.blocks.emplace_back(current);
+        }
+        cfg.blocks[current].quads.push_back(quad);
+        if (quad.op == Op::Goto || quad.op == Op::IfFalse || quad.op == Op::Return) {
+            current = -1;
+        }
+    }
+
+    cfg.computeEdges();
+    cfg.computeDominators();
+    return cfg;
+}
+
+vector<Quad> CFG::linearize() const {
+    vector<Quad> quads;
+    for (const auto& block : blocks) {
+        if (!block.label.isNone()) quads.push_back(Quad(Op::Label, Operand(), Operand(), block.label));
+        quads.insert(quads.end(), block.quads.begin(), block.quads.end());
+    }
+    return quads;
+}
+
+void CFG::computeEdges() {
+    vector<vector<int>> oldPreds(blocks.size());
+    for (auto& block : blocks) {
+        if (!block.phis.empty()) oldPreds[block.id] = block.preds;
+    }
+
+    labelToBlock.clear();
+    for (auto& block : blocks) {
+        block.preds.clear();
+        block.succs.clear();
+        if (!block.label.isNone()) labelToBlock[block.label.payload()] = block.id;
+    }
+
+    for (auto& block : blocks) {
+        const Quad* term = block.terminator();
+        bool hasNext = block.id + 1 < static_cast<int>(blocks.size());
+        if (block.fallsThrough() && hasNext) addEdge(blocks, block.id, block.id + 1);
+        if (term && (term->op == Op::Goto || term->op == Op::IfFalse)) {
+            int target = blockForLabel(term->result);
+            if (target >= 0) addEdge(blocks, block.id, target);
+        }
+    }
+
+    for (auto& block : blocks) {
+        if (block.phis.empty() || oldPreds[block.id] == block.preds) continue;
+        const auto& before = oldPreds[block.id];
+        for (auto& phi : block.phis) {
+            vector<Operand> args(block.preds.size());
+            for (size_t i = 0; i < block.preds.size(); i++) {
+                auto it = find(before.begin(), before.end(), block.preds[i]);
+                if (it != before.end()) args[i] = phi.args[it - before.begin()];
+            }
+            phi.args = move(args);
+        }
+        invalidateBlock(block.id);
+    }
+}
+
+int CFG::blockForLabel(Operand label) const {
+    auto it = labelToBlock.find(label.payload());
+    return it == labelToBlock.end() ? -1 : it->second;
+}
+
+vector<int> CFG::reversePostorder() const {
+    vector<int> order;
+    if (blocks.empty()) return order;
+    vector<char> visited(blocks.size(), 0);
+    vector<pair<int, size_t>> stack;
+    stack.push_back({0, 0});
+    visited[0] = 1;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const auto& succs = blocks[top.first].succs;
+        if (top.second < succs.size()) {
+            int next = succs[top.second++];
+            if (!visited[next]) {
+                visited[next] = 1;
+                stack.push_back({next, 0});
+            }
+        } else {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+void CFG::computeDominators() {
+    vector<int> rpo = reversePostorder();
+    rpoNumber.assign(blocks.size(), -1);
+    for (size_t i = 0; i < rpo.size(); i++) rpoNumber[rpo[i]] = static_cast<int>(i);
+
+    vector<int> idom(blocks.size(), -1);
+    if (!blocks.empty()) idom[0] = 0;
+
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (rpoNumber[a] > rpoNumber[b]) a = idom[a];
+            while (rpoNumber[b] > rpoNumber[a]) b = idom[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); i++) {
+            int b = rpo[i];
+            int newIdom = -1;
+            for (int p : blocks[b].preds) {
+                if (idom[p] == -1) continue;
+                newIdom = newIdom == -1 ? p : intersect(p, newIdom);
+            }
+            if (newIdom != idom[b]) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto& block : blocks) {
+        block.domChildren.clear();
+        block.idom = block.id == 0 ? -1 : idom[block.id];
+    }
+    for (auto& block : blocks) {
+        if (block.idom >= 0) blocks[block.idom].domChildren.push_back(block.id);
+    }
+}
+
+int CFG::removeUnreachable() {
+    vector<int> newId(blocks.size(), -1);
+    vector<BasicBlock> kept;
+    for (auto& block : blocks) {
+        if (!isReachable(block.id)) continue;
+        newId[block.id] = static_cast<int>(kept.size());
+        kept.push_back(move(block));
+    }
+    int removed = static_cast<int>(blocks.size() - kept.size());
+    if (removed == 0) {
+        blocks = move(kept);
+        return 0;
+    }
+
+    // A reachable block only falls through into a reachable one, so the
+    // layout stays valid. Phi arguments from dropped predecessors go away.
+    for (size_t i = 0; i < kept.size(); i++) {
+        auto& block = kept[i];
+        block.id = static_cast<int>(i);
+        vector<int> preds;
+        vector<size_t> keptArgs;
+        for (size_t j = 0; j < block.preds.size(); j++) {
+            if (newId[block.preds[j]] < 0) continue;
+            preds.push_back(newId[block.preds[j]]);
+            keptArgs.push_back(j);
+        }
+        for (auto& phi : block.phis) {
+            vector<Operand> args;
+            for (size_t j : keptArgs) args.push_back(phi.args[j]);
+            phi.args = move(args);
+        }
+        block.preds = move(preds);
+    }
+    blocks = move(kept);
+    invalidateDefUse();
+    computeEdges();
+    computeDominators();
+    return removed;
+}
+
+int CFG::insertBlock(int position) {
+    auto shift = [position](int& id) {
+        if (id >= position) id++;
+    };
+    for (auto& block : blocks) {
+        for (int& p : block.preds) shift(p);
+        for (int& s : block.succs) shift(s);
+        for (int& c : block.domChildren) shift(c);
+        if (block.idom >= 0) shift(block.idom);
+    }
+    for (auto& entry : labelToBlock) shift(entry.second);
+    blocks.insert(blocks.begin() + position, BasicBlock(position));
+    for (size_t i = 0; i < blocks.size(); i++) blocks[i].id = static_cast<int>(i);
+    invalidateDefUse();
+    return position;
+}
+
+void CFG::removeBlock(int block) {
+    auto renumber = [block](vector<int>& ids) {
+        ids.erase(remove(ids.begin(), ids.end(), block), ids.end());
+        for (int& id : ids) {
+            if (id > block) id--;
+        }
+    };
+    for (auto& b : blocks) {
+        auto edge = find(b.preds.begin(), b.preds.end(), block);
+        if (edge != b.preds.end()) {
+            for (auto& phi : b.phis) phi.args.erase(phi.args.begin() + (edge - b.preds.begin()));
+        }
+        renumber(b.preds);
+        renumber(b.succs);
+        renumber(b.domChildren);
+        if (b.idom == block) b.idom = -1;
+        else if (b.idom > block) b.idom--;
+    }
+    blocks.erase(blocks.begin() + block);
+    for (size_t i = 0; i < blocks.size(); i++) blocks[i].id = static_cast<int>(i);
+    invalidateDefUse();
+    labelToBlock.clear();
+    for (const auto& b : blocks) {
+        if (!b.label.isNone()) labelToBlock[b.label.payload()] = b.id;
+    }
+}
+
+Operand CFG::labelOf(int block) {
+    if (blocks[block].label.isNone()) {
+        blocks[block].label = newLabel();
+        labelToBlock[blocks[block].label.payload()] = block;
+    }
+    return blocks[block].label;
+}
+
+namespace {
+    vector<int> loopBody(const CFG& cfg, int header, const vector<int>& latches) {
+        vector<char> inLoop(cfg.blocks.size(), 0);
+        inLoop[header] = 1;
+        vector<int> stack(latches);
+        while (!stack.empty()) {
+            int b = stack.back();
+            stack.pop_back();
+            if (inLoop[b]) continue;
+            inLoop[b] = 1;
+            for (int p : cfg.blocks[b].preds) {
+                if (cfg.isReachable(p)) stack.push_back(p);
+            }
+        }
+        vector<int> body;
+        for (size_t b = 0; b < inLoop.size(); b++) {
+            if (inLoop[b]) body.push_back(static_cast<int>(b));
+        }
+        return body;
+    }
+
+    vector<int> latchesOf(const CFG& cfg, int header) {
+        vector<int> latches;
+        for (int p : cfg.blocks[header].preds) {
+            if (cfg.dominates(header, p)) latches.push_back(p);
+        }
+        return latches;
+    }
+}
+
+vector<Loop> CFG::naturalLoops() const {
+    vector<Loop> loops;
+    for (const auto& block : blocks) {
+        if (!isReachable(block.id)) continue;
+        vector<int> latches = latchesOf(*this, block.id);
+        if (latches.empty()) continue;
+        loops.push_back({block.id, loopBody(*this, block.id, latches)});
+    }
+    stable_sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    return loops;
+}
+
+int CFG::ensurePreheader(int header) {
+    vector<int> latches = latchesOf(*this, header);
+    if (latches.empty()) return -1;
+    Loop loop{header, loopBody(*this, header, latches)};
+
+    vector<int> outside;
+    unordered_map<int, vector<Operand>> incoming; // outside pred -> header phi inputs
+    const auto& preds = blocks[header].preds;
+    for (size_t i = 0; i < preds.size(); i++) {
+        if (loop.contains(preds[i])) continue;
+        outside.push_back(preds[i]);
+        for (const auto& phi : blocks[header].phis) incoming[preds[i]].push_back(phi.args[i]);
+    }
+    if (outside.empty()) return -1;
+    if (outside.size() == 1 && blocks[outside[0]].succs.size() == 1) return outside[0];
+    if (blocks[header].label.isNone()) return -1;
+
+    // A latch just above the header would fall into the preheader instead.
+    BasicBlock& above = blocks[header - 1];
+    if (loop.contains(above.id) && above.fallsThrough()) {
+        if (above.terminator()) return -1;
+        above.quads.push_back(Quad(Op::Goto, Operand(), Operand(), blocks[header].label));
+    }
+
+    Operand headerLabel = blocks[header].label;
+    bool jumpedTo = false;
+    for (int p : outside) {
+        const Quad* term = blocks[p].terminator();
+        jumpedTo = jumpedTo || (term && term->op != Op::Return && term->result == headerLabel);
+    }
+    Operand label = jumpedTo ? newLabel() : Operand();
+
+    int pre = insertBlock(header);
+    header = pre + 1;
+    blocks[pre].label = label;
+    unordered_map<int, vector<Operand>> shifted;
+    for (int& p : outside) {
+        if (p >= pre) p++;
+        shifted[p] = move(incoming[p >= pre ? p - 1 : p]);
+        Quad* term = blocks[p].quads.empty() ? nullptr : &blocks[p].quads.back();
+        if (term && (term->op == Op::Goto || term->op == Op::IfFalse) && term->result == headerLabel) {
+            term->result = label;
+        }
+    }
+    computeEdges();
+
+    // The header now has a single entry edge; several old entries meet in
+    // a phi in the preheader.
+    BasicBlock& head = blocks[header];
+    BasicBlock& preheader = blocks[pre];
+    size_t slot = find(head.preds.begin(), head.preds.end(), pre) - head.preds.begin();
+    for (size_t k = 0; k < head.phis.size(); k++) {
+        if (outside.size() == 1) {
+            head.phis[k].args[slot] = shifted[outside[0]][k];
+            continue;
+        }
+        Phi merged;
+        merged.var = head.phis[k].var;
+        merged.result = newTemp();
+        for (int p : preheader.preds) merged.args.push_back(shifted[p][k]);
+        preheader.phis.push_back(merged);
+        head.phis[k].args[slot] = merged.result;
+    }
+    invalidateBlock(pre);
+    invalidateBlock(header);
+    computeDominators();
+    return pre;
+}
+
+bool CFG::dominates(int a, int b) const {
+    if (!isReachable(b)) return false;
+    for (int walk = b; walk != -1; walk = blocks[walk].idom) {
+        if (walk == a) return true;
+    }
+    return false;
+}
+
+void CFG::print(ostream& out) const {
+    for (const auto& block : blocks) {
+        out << "B" << block.id;
+        if (!block.label.isNone()) out << " (" << block.label.toString() << ")";
+        out << "  preds:";
+        for (int p : block.preds) out << " B" << p;
+        out << "  succs:";
+        for (int s : block.succs) out << " B" << s;
+        out << "  idom: ";
+        if (block.idom >= 0) out << "B" << block.idom; else out << "-";
+        out << endl;
+        for (const auto& phi : block.phis) out << "    " << phi.toString() << endl;
+        for (const auto& quad : block.quads) out << "    " << quad.toString() << endl;
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef CFG_HPP
+#define CFG_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include "tac.hpp"
+#include "def_use.hpp"
+
+using namespace std;
+
+/**
+ * @brief An SSA phi node; args[i] is the value flowing in from preds[i].
+ */
+struct Phi {
+    Operand result;
+    Operand var; // source variable this phi merges
+    vector<Operand> args;
+
+    string toString() const {
+        string text = result.toString() + " = phi(";
+        for (size_t i = 0; i < args.size(); i++) {
+            if (i) text += ", ";
+            text += args[i].toString();
+        }
+        return text + ")";
+    }
+};
+
+/**
+ * @brief A maximal straight-line run of quads. The block's label (if any)
+ * is kept in `label`, not in `quads`; a jump or return, if present, is the
+ * last quad. Blocks that do not end in goto/return fall through to the
+ * next block in layout order.
+ */
+struct BasicBlock {
+    int id;
+    Operand label;
+    vector<Phi> phis; // only while the CFG is in SSA form
+    vector<Quad> quads;
+    vector<int> preds;
+    vector<int> succs;
+    int idom = -1;           // immediate dominator, -1 for the entry and unreachable blocks
+    vector<int> domChildren; // dominator tree
+
+    explicit BasicBlock(int i) : id(i) {}
+
+    const Quad* terminator() const {
+        if (quads.empty()) return nullptr;
+        const Quad& last = quads.back();
+        if (last.op == Op::Goto || last.op == Op::IfFalse || last.op == Op::Return) return &last;
+        return nullptr;
+    }
+
+    // True if control can continue into the next block in layout order.
+    bool fallsThrough() const {
+        const Quad* term = terminator();
+        return !term || term->op == Op::IfFalse;
+    }
+};
+
+/**
+ * @brief A natural loop: the header plus every block that reaches one of
+ * its back edges without passing through the header. Sorted by block id.
+ */
+struct Loop {
+    int header;
+    vector<int> blocks;
+
+    bool contains(int block) const { return binary_search(blocks.begin(), blocks.end(), block); }
+};
+
+/**
+ * @brief Control-flow graph over a function's TAC. blocks[0] is the entry
+ * and never has predecessors.
+ */
+class CFG {
+private:
+    unordered_map<uint32_t, int> labelToBlock;
+    vector<int> rpoNumber;
+    DefUseIndex defUseIndex;
+
+public:
+    vector<BasicBlock> blocks;
+    uint32_t tempCount = 0;  // temps _t0 .. _t(tempCount-1) may be in use
+    uint32_t labelCount = 0; // likewise for labels
+
+    static CFG build(const vector<Quad>& quads);
+    vector<Quad> linearize() const;
+
+    // Recomputes label lookup, preds and succs from the blocks' quads and
+    // layout. Phi arguments follow their predecessor; new edges get none.
+    void computeEdges();
+    // Fills idom/domChildren (Cooper, Harvey & Kennedy); needs computeEdges().
+    void computeDominators();
+    // Drops blocks the entry cannot reach and renumbers the rest. Returns
+    // the number of blocks removed.
+    int removeUnreachable();
+    // Inserts an empty, unlabeled block at `position` in the layout and
+    // renumbers the blocks after it; edges are only renamed. The caller
+    // fixes the quads, then calls computeEdges() and computeDominators().
+    int insertBlock(int position);
+    // Deletes a block nothing reaches any more and renumbers the rest;
+    // edges to it are dropped. Call computeEdges() afterwards.
+    void removeBlock(int block);
+    // Gives the loop headed by `header` a block whose only successor is
+    // the header and which all entries into the loop pass through. Returns
+    // its id, or -1 if the layout does not allow one.
+    int ensurePreheader(int header);
+
+    // Natural loops, one per header, innermost (smallest) first.
+    vector<Loop> naturalLoops() const;
+
+    vector<int> reversePostorder() const;
+    bool dominates(int a, int b) const;
+    bool isReachable(int block) const { return block == 0 || blocks[block].idom != -1; }
+    int blockForLabel(Operand label) const;
+
+    Operand newTemp() { return Operand::temp(tempCount++); }
+    Operand newLabel() { return Operand::label(labelCount++); }
+    // The block's label, creating one if it has none yet.
+    Operand labelOf(int block);
+
+    // Def-use chains, rescanned where invalidated since the last call.
+    // Passes call invalidateBlock() after editing a block's quads or phis;
+    // the CFG's own edits that add, drop or renumber blocks invalidate all.
+    DefUseIndex& defUse() {
+        defUseIndex.refresh(*this);
+        return defUseIndex;
+    }
+    void invalidateBlock(int block) { defUseIndex.invalidateBlock(block); }
+    void invalidateDefUse() { defUseIndex.invalidate(); }
+
+    void print(ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,344 @@
+#ifndef CONSTANT_FOLDER_HPP
+#define CONSTANT_FOLDER_HPP
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "Utilities/token_types.hpp"
+#include "ast.hpp"
+#include "ast_interpreter.hpp"
+#include "type_checker.hpp"
+
+using namespace std;
+
+/**
+ * @brief Folds constant expressions and prunes branches that can never run.
+ *
+ * Runs after type checking. Ints are 64-bit and wrap on overflow, as the
+ * generated code computes them, an int mixed with a float is promoted to
+ * float, and division or modulo by zero is left for run time. Operands with side effects (calls, assignments)
+ * are never discarded. Calls to functions the type checker marked pure are
+ * evaluated by ASTInterpreter when every argument is a constant.
+ */
+class ConstantFolder {
+private:
+    int foldedExprs = 0;
+    int prunedBranches = 0;
+    int evaluatedCalls = 0;
+    unordered_map<Name, FunctionDecl*> pureFunctions;
+    long stepBudget = ASTInterpreter::DEFAULT_STEP_BUDGET;
+
+    static bool isConstant(Expr* expr) {
+        return expr && (expr->nodeType == NODE_INT_LIT || expr->nodeType == NODE_FLOAT_LIT ||
+                        expr->nodeType == NODE_BOOL_LIT);
+    }
+
+    static bool isNumber(Expr* expr) {
+        return expr && (expr->nodeType == NODE_INT_LIT || expr->nodeType == NODE_FLOAT_LIT);
+    }
+
+    static double asDouble(Expr* expr) {
+        if (expr->nodeType == NODE_INT_LIT) return static_cast<IntLiteral*>(expr)->value;
+        return static_cast<FloatLiteral*>(expr)->value;
+    }
+
+    // Arithmetic is done on uint64_t so that overflow wraps instead of
+    // being undefined.
+    static int64_t wrap(uint64_t value) {
+        return static_cast<int64_t>(value);
+    }
+
+    static bool hasSideEffects(Expr* expr) {
+        if (!expr) return false;
+        switch (expr->nodeType) {
+            case NODE_FUNC_CALL:
+            case NODE_ASSIGNMENT:
+                return true;
+            case NODE_BINARY_OP: {
+                auto* bin = static_cast<BinaryOp*>(expr);
+                return hasSideEffects(bin->left) || hasSideEffects(bin->right);
+            }
+            case NODE_UNARY_OP:
+                return hasSideEffects(static_cast<UnaryOp*>(expr)->operand);
+            default:
+                return false;
+        }
+    }
+
+    // Returns the folded literal, or nullptr if the operation must stay at run time.
+    Expr* evaluateBinary(TokenType op, Expr* left, Expr* right) {
+        if (left->nodeType == NODE_BOOL_LIT && right->nodeType == NODE_BOOL_LIT) {
+            bool l = static_cast<BoolLiteral*>(left)->value;
+            bool r = static_cast<BoolLiteral*>(right)->value;
+            switch (op) {
+                case T_AND_LOGICAL_RL: return new BoolLiteral(l && r);
+                case T_OR_LOGICAL_RL: return new BoolLiteral(l || r);
+                case T_EQUALSOP_RL: return new BoolLiteral(l == r);
+                case T_NOT_EQUALS_RL: return new BoolLiteral(l != r);
+                case T_LESS_THAN_RL: return new BoolLiteral(l < r);
+                case T_GREATER_THAN_RL: return new BoolLiteral(l > r);
+                case T_LESS_EQUAL_RL: return new BoolLiteral(l <= r);
+                case T_GREATER_EQUAL_RL: return new BoolLiteral(l >= r);
+                default: return nullptr;
+            }
+        }
+        if (!isNumber(left) || !isNumber(right)) return nullptr;
+
+        if (left->nodeType == NODE_INT_LIT && right->nodeType == NODE_INT_LIT) {
+            int64_t l = static_cast<IntLiteral*>(left)->value;
+            int64_t r = static_cast<IntLiteral*>(right)->value;
+            switch (op) {
+                case T_PLUS_RL: return new IntLiteral(wrap(static_cast<uint64_t>(l) + r));
+                case T_MINUS_RL: return new IntLiteral(wrap(static_cast<uint64_t>(l) - r));
+                case T_MUL_RL: return new IntLiteral(wrap(static_cast<uint64_t>(l) * r));
+                case T_DIV_RL:
+                    if (r == 0 || (l == INT64_MIN && r == -1)) return nullptr;
+                    return new IntLiteral(l / r);
+                case T_MOD_RL:
+                    if (r == 0 || (l == INT64_MIN && r == -1)) return nullptr;
+                    return new IntLiteral(l % r);
+                case T_AND_BIT_RL: return new IntLiteral(l & r);
+                case T_OR_BIT_RL: return new IntLiteral(l | r);
+                case T_XOR_BIT_RL: return new IntLiteral(l ^ r);
+                case T_EQUALSOP_RL: return new BoolLiteral(l == r);
+                case T_NOT_EQUALS_RL: return new BoolLiteral(l != r);
+                case T_LESS_THAN_RL: return new BoolLiteral(l < r);
+                case T_GREATER_THAN_RL: return new BoolLiteral(l > r);
+                case T_LESS_EQUAL_RL: return new BoolLiteral(l <= r);
+                case T_GREATER_EQUAL_RL: return new BoolLiteral(l >= r);
+                default: return nullptr;
+            }
+        }
+
+        // Comparisons require both sides to have the same type.
+        bool mixed = left->nodeType != right->nodeType;
+        double l = asDouble(left);
+        double r = asDouble(right);
+        switch (op) {
+            case T_PLUS_RL: return new FloatLiteral(l + r);
+            case T_MINUS_RL: return new FloatLiteral(l - r);
+            case T_MUL_RL: return new FloatLiteral(l * r);
+            case T_DIV_RL:
+                if (r == 0.0) return nullptr;
+                return new FloatLiteral(l / r);
+            case T_EQUALSOP_RL: return mixed ? nullptr : new BoolLiteral(l == r);
+            case T_NOT_EQUALS_RL: return mixed ? nullptr : new BoolLiteral(l != r);
+            case T_LESS_THAN_RL: return mixed ? nullptr : new BoolLiteral(l < r);
+            case T_GREATER_THAN_RL: return mixed ? nullptr : new BoolLiteral(l > r);
+            case T_LESS_EQUAL_RL: return mixed ? nullptr : new BoolLiteral(l <= r);
+            case T_GREATER_EQUAL_RL: return mixed ? nullptr : new BoolLiteral(l >= r);
+            default: return nullptr;
+        }
+    }
+
+    // `sahi && x` is x, `galat && x` is galat when x is pure, and dually for ||.
+    Expr* simplifyLogical(BinaryOp* bin) {
+        if (bin->op != T_AND_LOGICAL_RL && bin->op != T_OR_LOGICAL_RL) return nullptr;
+        bool isAnd = bin->op == T_AND_LOGICAL_RL;
+        Expr*& constSide = bin->left->nodeType == NODE_BOOL_LIT ? bin->left : bin->right;
+        Expr*& otherSide = &constSide == &bin->left ? bin->right : bin->left;
+        if (constSide->nodeType != NODE_BOOL_LIT) return nullptr;
+
+        bool value = static_cast<BoolLiteral*>(constSide)->value;
+        if (value == isAnd) {
+            Expr* kept = otherSide;
+            otherSide = nullptr;
+            return kept;
+        }
+        if (hasSideEffects(otherSide)) return nullptr;
+        return new BoolLiteral(value);
+    }
+
+    Expr* foldExpression(Expr* expr) {
+        if (!expr) return expr;
+
+        switch (expr->nodeType) {
+            case NODE_BINARY_OP: {
+                auto* bin = static_cast<BinaryOp*>(expr);
+                bin->left = foldExpression(bin->left);
+                bin->right = foldExpression(bin->right);
+                Expr* folded = nullptr;
+                if (isConstant(bin->left) && isConstant(bin->right)) {
+                    folded = evaluateBinary(bin->op, bin->left, bin->right);
+                } else if (bin->left && bin->right) {
+                    folded = simplifyLogical(bin);
+                }
+                if (!folded) return expr;
+                foldedExprs++;
+                delete bin;
+                return folded;
+            }
+            case NODE_UNARY_OP: {
+                auto* un = static_cast<UnaryOp*>(expr);
+                un->operand = foldExpression(un->operand);
+                Expr* operand = un->operand;
+                Expr* folded = nullptr;
+                if (un->op == T_MINUS_RL && operand && operand->nodeType == NODE_INT_LIT) {
+                    folded = new IntLiteral(wrap(0 - static_cast<uint64_t>(static_cast<IntLiteral*>(operand)->value)));
+                } else if (un->op == T_MINUS_RL && operand && operand->nodeType == NODE_FLOAT_LIT) {
+                    folded = new FloatLiteral(-static_cast<FloatLiteral*>(operand)->value);
+                } else if (un->op == T_NOT_RL && operand && operand->nodeType == NODE_BOOL_LIT) {
+                    folded = new BoolLiteral(!static_cast<BoolLiteral*>(operand)->value);
+                }
+                if (!folded) return expr;
+                foldedExprs++;
+                delete un;
+                return folded;
+            }
+            case NODE_ASSIGNMENT: {
+                auto* assign = static_cast<Assignment*>(expr);
+                assign->value = foldExpression(assign->value);
+                return expr;
+            }
+            case NODE_FUNC_CALL: {
+                auto* call = static_cast<FunctionCall*>(expr);
+                for (auto& arg : call->args) {
+                    arg = foldExpression(arg);
+                }
+                Expr* folded = evaluateCall(call);
+                if (!folded) return expr;
+                evaluatedCalls++;
+                delete call;
+                return folded;
+            }
+            default:
+                return expr;
+        }
+    }
+
+    Expr* evaluateCall(FunctionCall* call) {
+        if (!pureFunctions.count(call->name)) return nullptr;
+        vector<ConstValue> args;
+        for (auto arg : call->args) {
+            ConstValue value;
+            if (!ConstValue::fromLiteral(arg, value)) return nullptr;
+            args.push_back(value);
+        }
+        ASTInterpreter interpreter(pureFunctions, stepBudget);
+        ConstValue result;
+        if (!interpreter.call(call->name, args, result)) return nullptr;
+        return result.toLiteral();
+    }
+
+    static bool isConstantBool(Expr* expr, bool value) {
+        return expr && expr->nodeType == NODE_BOOL_LIT &&
+               static_cast<BoolLiteral*>(expr)->value == value;
+    }
+
+    // Returns the statement to keep in place of `stmt`; nullptr drops it.
+    Stmt* foldStatement(Stmt* stmt) {
+        if (!stmt) return stmt;
+
+        switch (stmt->nodeType) {
+            case NODE_VAR_DECL: {
+                auto* decl = static_cast<VarDecl*>(stmt);
+                decl->expr = foldExpression(decl->expr);
+                return stmt;
+            }
+            case NODE_EXPR_STMT: {
+                auto* exprStmt = static_cast<ExprStmt*>(stmt);
+                exprStmt->expr = foldExpression(exprStmt->expr);
+                return stmt;
+            }
+            case NODE_RETURN: {
+                auto* ret = static_cast<ReturnStmt*>(stmt);
+                ret->expr = foldExpression(ret->expr);
+                return stmt;
+            }
+            case NODE_BLOCK: {
+                foldBlock(static_cast<Block*>(stmt)->stmts);
+                return stmt;
+            }
+            case NODE_IF: {
+                auto* ifStmt = static_cast<IfStmt*>(stmt);
+                ifStmt->condition = foldExpression(ifStmt->condition);
+                ifStmt->thenBranch = foldStatement(ifStmt->thenBranch);
+                ifStmt->elseBranch = foldStatement(ifStmt->elseBranch);
+                if (ifStmt->condition && ifStmt->condition->nodeType == NODE_BOOL_LIT) {
+                    Stmt*& taken = static_cast<BoolLiteral*>(ifStmt->condition)->value
+                                       ? ifStmt->thenBranch
+                                       : ifStmt->elseBranch;
+                    Stmt* kept = taken;
+                    taken = nullptr;
+                    prunedBranches++;
+                    delete ifStmt;
+                    return kept;
+                }
+                return stmt;
+            }
+            case NODE_WHILE: {
+                auto* whileStmt = static_cast<WhileStmt*>(stmt);
+                whileStmt->condition = foldExpression(whileStmt->condition);
+                if (isConstantBool(whileStmt->condition, false)) {
+                    prunedBranches++;
+                    delete whileStmt;
+                    return nullptr;
+                }
+                whileStmt->body = foldStatement(whileStmt->body);
+                return stmt;
+            }
+            case NODE_FOR: {
+                auto* forStmt = static_cast<ForStmt*>(stmt);
+                forStmt->init = foldStatement(forStmt->init);
+                forStmt->condition = foldExpression(forStmt->condition);
+                if (isConstantBool(forStmt->condition, false)) {
+                    // Only the initializer runs; keep it in its own scope.
+                    prunedBranches++;
+                    Block* block = nullptr;
+                    if (forStmt->init) {
+                        block = new Block();
+                        block->stmts.push_back(forStmt->init);
+                        forStmt->init = nullptr;
+                    }
+                    delete forStmt;
+                    return block;
+                }
+                forStmt->update = foldExpression(forStmt->update);
+                forStmt->body = foldStatement(forStmt->body);
+                return stmt;
+            }
+            case NODE_FUNC_DECL: {
+                auto* func = static_cast<FunctionDecl*>(stmt);
+                func->body = foldStatement(func->body);
+                if (!func->body) func->body = new Block();
+                return stmt;
+            }
+            default:
+                return stmt;
+        }
+    }
+
+    void foldBlock(vector<Stmt*>& stmts) {
+        size_t kept = 0;
+        for (size_t i = 0; i < stmts.size(); i++) {
+            Stmt* folded = foldStatement(stmts[i]);
+            if (folded) stmts[kept++] = folded;
+        }
+        stmts.resize(kept);
+    }
+
+public:
+    ConstantFolder() = default;
+
+    // With a checker, calls to its pure functions are evaluated as well.
+    void fold(vector<Stmt*>& program, const TypeChecker* checker = nullptr) {
+        pureFunctions.clear();
+        if (checker) {
+            for (auto* stmt : program) {
+                if (stmt->nodeType != NODE_FUNC_DECL) continue;
+                auto* func = static_cast<FunctionDecl*>(stmt);
+                if (checker->isPureFunction(func->name)) pureFunctions.insert({func->name, func});
+            }
+        }
+        foldBlock(program);
+    }
+
+    void setStepBudget(long budget) { stepBudget = budget; }
+
+    int getFoldedCount() const { return foldedExprs; }
+    int getPrunedCount() const { return prunedBranches; }
+    int getEvaluatedCallCount() const { return evaluatedCalls; }
+};
+
+#endif
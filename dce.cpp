@@ -0,0 +1,58 @@
+#include "dce.hpp"
+#include <algorithm>
+
+namespace {
+    // A quad must stay if it has an effect beyond defining a temp.
+    bool isCritical(const Quad& quad) {
+        return !writesResult(quad.op) || isCall(quad.op) || !quad.result.isTemp();
+    }
+}
+
+void DeadCodeEliminator::run(CFG& cfg) {
+    removedBlockCount += cfg.removeUnreachable();
+
+    const DefUseIndex& chains = cfg.defUse();
+
+    vector<char> live(cfg.tempCount, 0);
+    vector<uint32_t> worklist;
+    auto need = [&](Operand operand) {
+        if (!operand.isTemp() || operand.payload() >= live.size() || live[operand.payload()]) return;
+        live[operand.payload()] = 1;
+        worklist.push_back(operand.payload());
+    };
+
+    for (const auto& block : cfg.blocks) {
+        for (const auto& quad : block.quads) {
+            if (!isCritical(quad)) continue;
+            if (writesResult(quad.op)) need(quad.result);
+            need(quad.arg1);
+            need(quad.arg2);
+        }
+    }
+    while (!worklist.empty()) {
+        Site def = chains.definitionOf(Operand::temp(worklist.back()));
+        worklist.pop_back();
+        if (def.block < 0) continue;
+        const BasicBlock& block = cfg.blocks[def.block];
+        if (def.isPhi()) {
+            for (Operand arg : block.phis[def.phi()].args) need(arg);
+        } else {
+            need(block.quads[def.index].arg1);
+            need(block.quads[def.index].arg2);
+        }
+    }
+
+    auto isLive = [&](Operand result) { return result.payload() < live.size() && live[result.payload()]; };
+    for (auto& block : cfg.blocks) {
+        size_t phis = block.phis.size(), quads = block.quads.size();
+        block.phis.erase(remove_if(block.phis.begin(), block.phis.end(),
+                                   [&](const Phi& phi) { return !isLive(phi.result); }),
+                         block.phis.end());
+        block.quads.erase(remove_if(block.quads.begin(), block.quads.end(),
+                                    [&](const Quad& quad) { return !isCritical(quad) && !isLive(quad.result); }),
+                          block.quads.end());
+        removedPhiCount += static_cast<int>(phis - block.phis.size());
+        removedQuadCount += static_cast<int>(quads - block.quads.size());
+        if (phis != block.phis.size() || quads != block.quads.size()) cfg.invalidateBlock(block.id);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef DCE_HPP
+#define DCE_HPP
+
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Dead code elimination over a CFG in SSA form. Blocks the entry
+ * cannot reach are dropped, then every quad and phi whose value is never
+ * needed by a jump, return, call or store is removed. Since each local
+ * variable write is its own temp in SSA, this also deletes dead stores.
+ */
+class DeadCodeEliminator {
+private:
+    int removedQuadCount = 0;
+    int removedPhiCount = 0;
+    int removedBlockCount = 0;
+
+public:
+    void run(CFG& cfg);
+
+    int getRemovedQuadCount() const { return removedQuadCount; }
+    int getRemovedPhiCount() const { return removedPhiCount; }
+    int getRemovedBlockCount() const { return removedBlockCount; }
+};
+
+#endif
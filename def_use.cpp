@@ -0,0 +1,119 @@
+#include "def_use.hpp"
+#include "cfg.hpp"
+#include <algorithm>
+
+namespace {
+    const vector<Site> noSites;
+
+    bool isTracked(Operand operand) {
+        return operand.isTemp() || operand.isVar();
+    }
+}
+
+void DefUseIndex::invalidateBlock(int block) {
+    if (!built) return;
+    if (block >= static_cast<int>(dirty.size())) {
+        built = false;
+        return;
+    }
+    if (dirty[block]) return;
+    dirty[block] = 1;
+    dirtyBlocks.push_back(block);
+}
+
+void DefUseIndex::refresh(const CFG& cfg) {
+    if (built && blockValues.size() == cfg.blocks.size()) {
+        for (int block : dirtyBlocks) {
+            dropBlock(block);
+            scanBlock(cfg, block);
+            dirty[block] = 0;
+        }
+        dirtyBlocks.clear();
+        return;
+    }
+    chains.clear();
+    blockValues.assign(cfg.blocks.size(), {});
+    dirty.assign(cfg.blocks.size(), 0);
+    dirtyBlocks.clear();
+    for (size_t b = 0; b < cfg.blocks.size(); b++) scanBlock(cfg, static_cast<int>(b));
+    built = true;
+}
+
+void DefUseIndex::scanBlock(const CFG& cfg, int block) {
+    const BasicBlock& source = cfg.blocks[block];
+    auto& values = blockValues[block];
+    auto note = [&](Operand value, Site site, bool def) {
+        if (!isTracked(value)) return;
+        Chains& entry = chains[value.bits];
+        (def ? entry.defs : entry.uses).push_back(site);
+        values.push_back(value.bits);
+    };
+    for (size_t j = 0; j < source.phis.size(); j++) {
+        Site site{block, -1 - static_cast<int>(j)};
+        note(source.phis[j].result, site, true);
+        for (Operand arg : source.phis[j].args) note(arg, site, false);
+    }
+    for (size_t i = 0; i < source.quads.size(); i++) {
+        const Quad& quad = source.quads[i];
+        Site site{block, static_cast<int>(i)};
+        note(quad.arg1, site, false);
+        note(quad.arg2, site, false);
+        if (writesResult(quad.op)) note(quad.result, site, true);
+    }
+    sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end()), values.end());
+}
+
+void DefUseIndex::dropBlock(int block) {
+    auto inBlock = [block](const Site& site) { return site.block == block; };
+    for (uint32_t value : blockValues[block]) {
+        Chains& entry = chains[value];
+        entry.defs.erase(remove_if(entry.defs.begin(), entry.defs.end(), inBlock), entry.defs.end());
+        entry.uses.erase(remove_if(entry.uses.begin(), entry.uses.end(), inBlock), entry.uses.end());
+    }
+    blockValues[block].clear();
+}
+
+const vector<Site>& DefUseIndex::definitionsOf(Operand value) const {
+    auto it = chains.find(value.bits);
+    return it == chains.end() ? noSites : it->second.defs;
+}
+
+Site DefUseIndex::definitionOf(Operand value) const {
+    const auto& defs = definitionsOf(value);
+    return defs.empty() ? Site() : defs.front();
+}
+
+const vector<Site>& DefUseIndex::usesOf(Operand value) const {
+    auto it = chains.find(value.bits);
+    return it == chains.end() ? noSites : it->second.uses;
+}
+
+void DefUseIndex::replaceAllUses(CFG& cfg, Operand from, Operand to) {
+    refresh(cfg);
+    auto it = chains.find(from.bits);
+    if (it == chains.end() || from == to) return;
+    vector<Site> sites = move(it->second.uses);
+    it->second.uses.clear();
+
+    for (const Site& site : sites) {
+        BasicBlock& block = cfg.blocks[site.block];
+        if (site.isPhi()) {
+            for (Operand& arg : block.phis[site.phi()].args) {
+                if (arg == from) arg = to;
+            }
+        } else {
+            Quad& quad = block.quads[site.index];
+            if (quad.arg1 == from) quad.arg1 = to;
+            if (quad.arg2 == from) quad.arg2 = to;
+        }
+    }
+    if (!isTracked(to)) return;
+    Chains& target = chains[to.bits];
+    target.uses.insert(target.uses.end(), sites.begin(), sites.end());
+    for (const Site& site : sites) {
+        auto& values = blockValues[site.block];
+        auto at = lower_bound(values.begin(), values.end(), to.bits);
+        if (at == values.end() || *at != to.bits) values.insert(at, to.bits);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef DEF_USE_HPP
+#define DEF_USE_HPP
+
+#include <unordered_map>
+#include <vector>
+#include "tac.hpp"
+
+using namespace std;
+
+class CFG;
+
+/**
+ * @brief Where in a CFG a value is defined or used: a quad of a block, or
+ * a phi when index is negative.
+ */
+struct Site {
+    int block = -1;
+    int index = 0; // quad index, or -1 - phi index
+
+    bool isPhi() const { return index < 0; }
+    int phi() const { return -1 - index; }
+};
+
+/**
+ * @brief Def-use and use-def chains for the temps and variables of a CFG.
+ * A use is one occurrence as arg1, arg2 or phi argument; a definition is a
+ * quad or phi writing the value. In SSA form every value has at most one.
+ *
+ * The index is kept by the CFG and brought up to date on demand. A pass
+ * that edits the quads or phis of a block calls CFG::invalidateBlock,
+ * and only that block is scanned again; edits that add, remove or
+ * renumber blocks drop the whole index.
+ */
+class DefUseIndex {
+private:
+    struct Chains {
+        vector<Site> defs;
+        vector<Site> uses;
+    };
+
+    unordered_map<uint32_t, Chains> chains;
+    vector<vector<uint32_t>> blockValues; // values each block mentions
+    vector<int> dirtyBlocks;
+    vector<char> dirty;
+    bool built = false;
+
+    void scanBlock(const CFG& cfg, int block);
+    void dropBlock(int block);
+
+public:
+    void invalidate() { built = false; }
+    void invalidateBlock(int block);
+    void refresh(const CFG& cfg);
+
+    const vector<Site>& definitionsOf(Operand value) const;
+    // The single definition of an SSA value; block is -1 if there is none.
+    Site definitionOf(Operand value) const;
+    const vector<Site>& usesOf(Operand value) const;
+    int useCount(Operand value) const { return static_cast<int>(usesOf(value).size()); }
+
+    // Rewrites every use of `from` to `to` in time proportional to the
+    // number of uses.
+    void replaceAllUses(CFG& cfg, Operand from, Operand to);
+};
+
+#endif
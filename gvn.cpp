@@ -0,0 +1,112 @@
+#include "gvn.hpp"
+#include <algorithm>
+
+namespace {
+    bool isCommutative(Op op) {
+        switch (op) {
+            case Op::Add: case Op::Mul:
+            case Op::BitAnd: case Op::BitOr: case Op::BitXor:
+            case Op::And: case Op::Or:
+            case Op::Eq: case Op::Ne:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+Operand GVN::lookup(Operand operand) const {
+    while (operand.isTemp() && operand.payload() < replacement.size() &&
+           !replacement[operand.payload()].isNone()) {
+        operand = replacement[operand.payload()];
+    }
+    return operand;
+}
+
+GVN::Expression GVN::keyFor(const Quad& quad) {
+    Expression key{quad.op, quad.arg1.bits, quad.arg2.bits};
+    if (isCommutative(quad.op) && key.a > key.b) swap(key.a, key.b);
+    return key;
+}
+
+void GVN::run(CFG& cfg) {
+    available.clear();
+    replacement.assign(cfg.tempCount, Operand());
+    if (!cfg.blocks.empty()) visit(cfg, 0);
+    cfg.invalidateDefUse();
+}
+
+void GVN::visit(CFG& cfg, int b) {
+    vector<Expression> scope;
+    BasicBlock& block = cfg.blocks[b];
+
+    // Phis: one whose inputs all agree is that input; one that repeats an
+    // earlier phi of the block is that phi.
+    vector<Phi> kept;
+    for (auto& phi : block.phis) {
+        for (auto& arg : phi.args) arg = lookup(arg);
+        // An undefined input counts as a value of its own: the defined one
+        // need not dominate this block.
+        Operand same;
+        bool seen = false, meaningless = true;
+        for (Operand arg : phi.args) {
+            if (arg == phi.result) continue;
+            if (seen && arg != same) {
+                meaningless = false;
+                break;
+            }
+            same = arg;
+            seen = true;
+        }
+        if (meaningless && !same.isNone()) {
+            replacement[phi.result.payload()] = same;
+            removedCount++;
+            continue;
+        }
+        auto twin = find_if(kept.begin(), kept.end(), [&](const Phi& other) { return other.args == phi.args; });
+        if (twin != kept.end()) {
+            replacement[phi.result.payload()] = twin->result;
+            removedCount++;
+            continue;
+        }
+        kept.push_back(phi);
+    }
+    block.phis = move(kept);
+
+    vector<Quad> quads;
+    for (Quad quad : block.quads) {
+        if (quad.op != Op::Label && quad.op != Op::Goto) {
+            quad.arg1 = lookup(quad.arg1);
+            quad.arg2 = lookup(quad.arg2);
+        }
+        bool numbered = quad.result.isTemp() && writesResult(quad.op) && !touchesMemory(quad.op);
+        if (numbered && quad.op == Op::Copy) {
+            replacement[quad.result.payload()] = quad.arg1;
+            removedCount++;
+            continue;
+        }
+        if (numbered) {
+            Expression key = keyFor(quad);
+            auto it = available.find(key);
+            if (it != available.end()) {
+                replacement[quad.result.payload()] = it->second;
+                removedCount++;
+                continue;
+            }
+            available.emplace(key, quad.result);
+            scope.push_back(key);
+        }
+        quads.push_back(quad);
+    }
+    block.quads = move(quads);
+
+    for (int s : block.succs) {
+        auto& succ = cfg.blocks[s];
+        size_t slot = find(succ.preds.begin(), succ.preds.end(), b) - succ.preds.begin();
+        for (auto& phi : succ.phis) phi.args[slot] = lookup(phi.args[slot]);
+    }
+
+    for (int child : cfg.blocks[b].domChildren) visit(cfg, child);
+
+    for (const auto& key : scope) available.erase(key);
+}
@@ -0,0 +1,48 @@
+#ifndef GVN_HPP
+#define GVN_HPP
+
+#include <vector>
+#include <unordered_map>
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Dominator-based global value numbering over a CFG in SSA form.
+ * Copies are propagated, meaningless or duplicate phis are folded, and a
+ * computation already available from a dominating block is replaced by
+ * the earlier temp.
+ */
+class GVN {
+private:
+    struct Expression {
+        Op op;
+        uint32_t a;
+        uint32_t b;
+
+        bool operator==(const Expression& other) const {
+            return op == other.op && a == other.a && b == other.b;
+        }
+    };
+
+    struct ExpressionHash {
+        size_t operator()(const Expression& e) const {
+            return (static_cast<size_t>(e.op) * 0x9E3779B1u) ^ (static_cast<size_t>(e.a) << 16) ^ e.b;
+        }
+    };
+
+    unordered_map<Expression, Operand, ExpressionHash> available;
+    vector<Operand> replacement; // indexed by temp number; none if the temp stands for itself
+    int removedCount = 0;
+
+    Operand lookup(Operand operand) const;
+    static Expression keyFor(const Quad& quad);
+    void visit(CFG& cfg, int block);
+
+public:
+    void run(CFG& cfg);
+
+    int getRemovedCount() const { return removedCount; }
+};
+
+#endif
@@ -0,0 +1,436 @@
+#ifndef INCREMENTAL_ANALYZER_HPP
+#define INCREMENTAL_ANALYZER_HPP
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "Utilities/token_types.hpp"
+#include "ast.hpp"
+#include "scope_analyzer.hpp"
+#include "type_checker.hpp"
+
+using namespace std;
+
+/**
+ * @brief Everything remembered about one analysis unit (a function, or the
+ * top-level statements) from the last time it was checked.
+ */
+struct UnitRecord {
+    size_t signatureHash = 0;
+    size_t bodyHash = 0;
+    vector<Name> freeNames;                   // globals and callees the body refers to
+    unordered_map<Name, string> dependencies; // free name -> symbol view it was checked against
+    int errors = 0;
+    bool locallyImpure = false;               // see TypeChecker::isLocallyImpure
+    vector<Name> callees;
+};
+
+/**
+ * @brief Re-runs ScopeAnalyzer and TypeChecker only on units whose own text
+ * changed, or whose globals / callee signatures changed, since the previous
+ * call to update(). Clean functions are only declared, never re-visited;
+ * their purity facts are carried over, so getTypeChecker() reports purity
+ * for the whole program as a full check would.
+ */
+class IncrementalAnalyzer {
+private:
+    unordered_map<Name, UnitRecord> records;
+    vector<Name> lastRechecked;
+    shared_ptr<Scope> globalScope;
+    unique_ptr<TypeChecker> typeChecker;
+    int declarationErrors = 0; // redefinitions, recounted on every update
+
+    // Pseudo-unit holding every statement outside a function.
+    static Name topLevel() {
+        static const Name name("<toplevel>");
+        return name;
+    }
+
+    static void combine(size_t &seed, size_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+
+    static size_t hashNode(ASTNode *node) {
+        if (!node) return 0x51ed27;
+        size_t h = hash<int>()(node->nodeType);
+        switch (node->nodeType) {
+        case NODE_INT_LIT:
+            combine(h, hash<int64_t>()(static_cast<IntLiteral *>(node)->value));
+            break;
+        case NODE_FLOAT_LIT:
+            combine(h, hash<double>()(static_cast<FloatLiteral *>(node)->value));
+            break;
+        case NODE_STRING_LIT:
+            combine(h, hash<string>()(static_cast<StringLiteral *>(node)->value));
+            break;
+        case NODE_BOOL_LIT:
+            combine(h, static_cast<BoolLiteral *>(node)->value);
+            break;
+        case NODE_IDENTIFIER:
+            combine(h, hash<Name>()(static_cast<Identifier *>(node)->name));
+            break;
+        case NODE_BINARY_OP: {
+            auto *bin = static_cast<BinaryOp *>(node);
+            combine(h, bin->op);
+            combine(h, hashNode(bin->left));
+            combine(h, hashNode(bin->right));
+            break;
+        }
+        case NODE_UNARY_OP: {
+            auto *un = static_cast<UnaryOp *>(node);
+            combine(h, un->op);
+            combine(h, hashNode(un->operand));
+            break;
+        }
+        case NODE_ASSIGNMENT: {
+            auto *as = static_cast<Assignment *>(node);
+            combine(h, hash<Name>()(as->ident));
+            combine(h, hashNode(as->value));
+            break;
+        }
+        case NODE_FUNC_CALL: {
+            auto *fc = static_cast<FunctionCall *>(node);
+            combine(h, hash<Name>()(fc->name));
+            for (auto arg : fc->args)
+                combine(h, hashNode(arg));
+            break;
+        }
+        case NODE_VAR_DECL: {
+            auto *vd = static_cast<VarDecl *>(node);
+            combine(h, vd->type);
+            combine(h, hash<Name>()(vd->ident));
+            combine(h, hashNode(vd->expr));
+            break;
+        }
+        case NODE_EXPR_STMT:
+            combine(h, hashNode(static_cast<ExprStmt *>(node)->expr));
+            break;
+        case NODE_RETURN:
+            combine(h, hashNode(static_cast<ReturnStmt *>(node)->expr));
+            break;
+        case NODE_BLOCK:
+            for (auto stmt : static_cast<Block *>(node)->stmts)
+                combine(h, hashNode(stmt));
+            break;
+        case NODE_IF: {
+            auto *is = static_cast<IfStmt *>(node);
+            combine(h, hashNode(is->condition));
+            combine(h, hashNode(is->thenBranch));
+            combine(h, hashNode(is->elseBranch));
+            break;
+        }
+        case NODE_WHILE: {
+            auto *wh = static_cast<WhileStmt *>(node);
+            combine(h, hashNode(wh->condition));
+            combine(h, hashNode(wh->body));
+            break;
+        }
+        case NODE_FOR: {
+            auto *f = static_cast<ForStmt *>(node);
+            combine(h, hashNode(f->init));
+            combine(h, hashNode(f->condition));
+            combine(h, hashNode(f->update));
+            combine(h, hashNode(f->body));
+            break;
+        }
+        case NODE_FUNC_DECL: {
+            auto *fd = static_cast<FunctionDecl *>(node);
+            for (auto &p : fd->params)
+                combine(h, hash<Name>()(p.name));
+            combine(h, hashNode(fd->body));
+            break;
+        }
+        default:
+            break;
+        }
+        return h;
+    }
+
+    static size_t hashSignature(FunctionDecl *fd) {
+        size_t h = hash<Name>()(fd->name);
+        combine(h, fd->returnType);
+        for (auto &p : fd->params)
+            combine(h, p.type);
+        return h;
+    }
+
+    // Collects names that do not resolve to a declaration inside the unit itself.
+    static void collectFreeNames(ASTNode *node, vector<unordered_set<Name>> &locals,
+                                 unordered_set<Name> &seen, vector<Name> &out) {
+        if (!node) return;
+        auto use = [&](Name name) {
+            for (auto it = locals.rbegin(); it != locals.rend(); ++it)
+                if (it->count(name)) return;
+            if (seen.insert(name).second) out.push_back(name);
+        };
+        switch (node->nodeType) {
+        case NODE_IDENTIFIER:
+            use(static_cast<Identifier *>(node)->name);
+            break;
+        case NODE_ASSIGNMENT: {
+            auto *as = static_cast<Assignment *>(node);
+            use(as->ident);
+            collectFreeNames(as->value, locals, seen, out);
+            break;
+        }
+        case NODE_FUNC_CALL: {
+            auto *fc = static_cast<FunctionCall *>(node);
+            use(fc->name);
+            for (auto arg : fc->args)
+                collectFreeNames(arg, locals, seen, out);
+            break;
+        }
+        case NODE_BINARY_OP: {
+            auto *bin = static_cast<BinaryOp *>(node);
+            collectFreeNames(bin->left, locals, seen, out);
+            collectFreeNames(bin->right, locals, seen, out);
+            break;
+        }
+        case NODE_UNARY_OP:
+            collectFreeNames(static_cast<UnaryOp *>(node)->operand, locals, seen, out);
+            break;
+        case NODE_VAR_DECL: {
+            auto *vd = static_cast<VarDecl *>(node);
+            collectFreeNames(vd->expr, locals, seen, out);
+            if (!locals.empty()) locals.back().insert(vd->ident);
+            break;
+        }
+        case NODE_EXPR_STMT:
+            collectFreeNames(static_cast<ExprStmt *>(node)->expr, locals, seen, out);
+            break;
+        case NODE_RETURN:
+            collectFreeNames(static_cast<ReturnStmt *>(node)->expr, locals, seen, out);
+            break;
+        case NODE_BLOCK:
+            locals.emplace_back();
+            for (auto stmt : static_cast<Block *>(node)->stmts)
+                collectFreeNames(stmt, locals, seen, out);
+            locals.pop_back();
+            break;
+        case NODE_IF: {
+            auto *is = static_cast<IfStmt *>(node);
+            collectFreeNames(is->condition, locals, seen, out);
+            collectFreeNames(is->thenBranch, locals, seen, out);
+            collectFreeNames(is->elseBranch, locals, seen, out);
+            break;
+        }
+        case NODE_WHILE: {
+            auto *wh = static_cast<WhileStmt *>(node);
+            collectFreeNames(wh->condition, locals, seen, out);
+            collectFreeNames(wh->body, locals, seen, out);
+            break;
+        }
+        case NODE_FOR: {
+            auto *f = static_cast<ForStmt *>(node);
+            locals.emplace_back();
+            collectFreeNames(f->init, locals, seen, out);
+            collectFreeNames(f->condition, locals, seen, out);
+            collectFreeNames(f->update, locals, seen, out);
+            collectFreeNames(f->body, locals, seen, out);
+            locals.pop_back();
+            break;
+        }
+        case NODE_FUNC_DECL: {
+            auto *fd = static_cast<FunctionDecl *>(node);
+            locals.emplace_back();
+            for (auto &p : fd->params)
+                locals.back().insert(p.name);
+            collectFreeNames(fd->body, locals, seen, out);
+            locals.pop_back();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    static string symbolKey(const Symbol *sym) {
+        if (!sym) return "-";
+        return string(sym->isFunction ? "f" : "v") + to_string(sym->type);
+    }
+
+    static string signatureKey(FunctionDecl *fd) {
+        string key = "fn" + to_string(fd->returnType) + "(";
+        for (auto &p : fd->params)
+            key += to_string(p.type) + ",";
+        return key + ")";
+    }
+
+    /**
+     * @brief What a unit sees for `name`: the symbol ScopeAnalyzer has
+     * declared at this point of the program, plus the final global entry
+     * TypeChecker resolves it against (signature or variable type).
+     */
+    static string viewOf(Name name, const unordered_map<Name, Symbol> &visible,
+                         const unordered_map<Name, string> &finalKeys) {
+        auto vis = visible.find(name);
+        auto fin = finalKeys.find(name);
+        return symbolKey(vis == visible.end() ? nullptr : &vis->second) + "|" +
+               (fin == finalKeys.end() ? "-" : fin->second);
+    }
+
+    static bool isDirty(const UnitRecord *old, const UnitRecord &fresh) {
+        if (!old) return true;
+        return old->signatureHash != fresh.signatureHash ||
+               old->bodyHash != fresh.bodyHash ||
+               old->dependencies != fresh.dependencies;
+    }
+
+public:
+    /**
+     * @brief Analyzes a freshly parsed program, re-checking only dirty units.
+     * @return the names of the units that were re-checked.
+     */
+    const vector<Name> &update(vector<Stmt *> &program) {
+        lastRechecked.clear();
+
+        // Final view of every global, as TypeChecker sees it after registration.
+        unordered_map<Name, string> finalKeys;
+        for (auto stmt : program) {
+            if (stmt->nodeType == NODE_FUNC_DECL) {
+                auto *fd = static_cast<FunctionDecl *>(stmt);
+                finalKeys.insert({fd->name, signatureKey(fd)});
+            } else if (stmt->nodeType == NODE_VAR_DECL) {
+                auto *vd = static_cast<VarDecl *>(stmt);
+                finalKeys.insert({vd->ident, "var" + to_string(vd->type)});
+            }
+        }
+
+        // Build fresh records in program order, tracking what is visible so far.
+        const Name TOP_LEVEL = topLevel();
+        unordered_map<Name, UnitRecord> fresh;
+        unordered_map<Name, Symbol> visible;
+        UnitRecord &top = fresh[TOP_LEVEL];
+        unordered_set<Name> topSeen;
+        for (auto stmt : program) {
+            if (stmt->nodeType == NODE_FUNC_DECL) {
+                auto *fd = static_cast<FunctionDecl *>(stmt);
+                if (!visible.count(fd->name))
+                    visible[fd->name] = Symbol(fd->name, fd->returnType, true);
+                if (fresh.count(fd->name)) continue;
+
+                UnitRecord rec;
+                rec.signatureHash = hashSignature(fd);
+                rec.bodyHash = hashNode(fd);
+                auto old = records.find(fd->name);
+                if (old != records.end() && old->second.bodyHash == rec.bodyHash) {
+                    rec.freeNames = old->second.freeNames;
+                } else {
+                    vector<unordered_set<Name>> locals;
+                    unordered_set<Name> seen;
+                    collectFreeNames(fd, locals, seen, rec.freeNames);
+                }
+                for (auto &name : rec.freeNames)
+                    rec.dependencies[name] = viewOf(name, visible, finalKeys);
+                fresh[fd->name] = move(rec);
+                continue;
+            }
+
+            combine(top.bodyHash, hashNode(stmt));
+            vector<Name> names;
+            vector<unordered_set<Name>> locals(1);
+            unordered_set<Name> seen;
+            collectFreeNames(stmt, locals, seen, names);
+            for (auto &name : names) {
+                if (topSeen.insert(name).second) top.freeNames.push_back(name);
+                top.dependencies[name] += viewOf(name, visible, finalKeys) + ";";
+            }
+            if (stmt->nodeType == NODE_VAR_DECL) {
+                auto *vd = static_cast<VarDecl *>(stmt);
+                if (!visible.count(vd->ident))
+                    visible[vd->ident] = Symbol(vd->ident, vd->type, false);
+            }
+        }
+
+        unordered_set<Name> dirty;
+        for (auto &entry : fresh) {
+            auto old = records.find(entry.first);
+            if (isDirty(old == records.end() ? nullptr : &old->second, entry.second)) {
+                dirty.insert(entry.first);
+            } else {
+                entry.second.errors = old->second.errors;
+                entry.second.locallyImpure = old->second.locallyImpure;
+                entry.second.callees = old->second.callees;
+            }
+        }
+
+        // Scope analysis walks in program order; clean units are only declared.
+        ScopeAnalyzer scopeAnalyzer;
+        unordered_set<Name> done;
+        bool topDirty = dirty.count(TOP_LEVEL) > 0;
+        declarationErrors = 0;
+        for (auto stmt : program) {
+            int before = scopeAnalyzer.getErrorCount();
+            if (stmt->nodeType == NODE_FUNC_DECL) {
+                auto *fd = static_cast<FunctionDecl *>(stmt);
+                scopeAnalyzer.declareFunction(fd);
+                declarationErrors += scopeAnalyzer.getErrorCount() - before;
+                if (dirty.count(fd->name) && done.insert(fd->name).second) {
+                    before = scopeAnalyzer.getErrorCount();
+                    scopeAnalyzer.analyzeFunctionBody(fd);
+                    fresh[fd->name].errors += scopeAnalyzer.getErrorCount() - before;
+                }
+            } else if (topDirty) {
+                scopeAnalyzer.analyze(stmt);
+                top.errors += scopeAnalyzer.getErrorCount() - before;
+            } else if (stmt->nodeType == NODE_VAR_DECL) {
+                // Any redefinition here is already part of the cached top-level errors.
+                scopeAnalyzer.declareVariable(static_cast<VarDecl *>(stmt));
+            }
+        }
+        globalScope = scopeAnalyzer.getGlobalScope();
+
+        typeChecker.reset(new TypeChecker());
+        typeChecker->registerFunctions(program, globalScope);
+        done.clear();
+        for (auto stmt : program) {
+            int before = typeChecker->getErrorCount();
+            if (stmt->nodeType == NODE_FUNC_DECL) {
+                auto *fd = static_cast<FunctionDecl *>(stmt);
+                if (!done.insert(fd->name).second) continue;
+                UnitRecord &rec = fresh[fd->name];
+                if (!dirty.count(fd->name)) {
+                    typeChecker->restorePurity(fd->name, rec.locallyImpure, rec.callees);
+                    continue;
+                }
+                typeChecker->checkFunctionDecl(fd);
+                rec.errors += typeChecker->getErrorCount() - before;
+                rec.locallyImpure = typeChecker->isLocallyImpure(fd->name);
+                rec.callees = typeChecker->calleesOf(fd->name);
+            } else if (topDirty) {
+                typeChecker->checkTopLevel(stmt);
+                top.errors += typeChecker->getErrorCount() - before;
+            }
+        }
+        typeChecker->computePurity();
+
+        for (auto stmt : program) {
+            if (stmt->nodeType != NODE_FUNC_DECL) continue;
+            auto &name = static_cast<FunctionDecl *>(stmt)->name;
+            if (dirty.count(name)) lastRechecked.push_back(name);
+        }
+        if (topDirty) lastRechecked.push_back(TOP_LEVEL);
+
+        records = move(fresh);
+        return lastRechecked;
+    }
+
+    int getErrorCount() const {
+        int total = declarationErrors;
+        for (auto &entry : records)
+            total += entry.second.errors;
+        return total;
+    }
+
+    const vector<Name> &getRechecked() const { return lastRechecked; }
+
+    shared_ptr<Scope> getGlobalScope() { return globalScope; }
+
+    // The checker from the last update(), for purity queries.
+    const TypeChecker *getTypeChecker() const { return typeChecker.get(); }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "inliner.hpp"
+#include <unordered_map>
+
+namespace {
+    void countNames(const vector<Quad>& quads, uint32_t& temps, uint32_t& labels) {
+        for (const auto& quad : quads) {
+            for (Operand operand : {quad.arg1, quad.arg2, quad.result}) {
+                if (operand.isTemp()) temps = max(temps, operand.payload() + 1);
+                if (operand.isLabel()) labels = max(labels, operand.payload() + 1);
+            }
+        }
+    }
+
+    // Marks the quads a backward jump spans. The IR generator lays every
+    // loop out as its header label followed by the body and the back edge.
+    vector<bool> loopQuads(const vector<Quad>& quads) {
+        unordered_map<uint32_t, size_t> labelAt;
+        for (size_t i = 0; i < quads.size(); i++) {
+            if (quads[i].op == Op::Label) labelAt[quads[i].result.bits] = i;
+        }
+        vector<int> depth(quads.size() + 1, 0);
+        for (size_t i = 0; i < quads.size(); i++) {
+            if (quads[i].op != Op::Goto && quads[i].op != Op::IfFalse) continue;
+            auto it = labelAt.find(quads[i].result.bits);
+            if (it == labelAt.end() || it->second > i) continue;
+            depth[it->second]++;
+            depth[i + 1]--;
+        }
+        vector<bool> inLoop(quads.size());
+        int open = 0;
+        for (size_t i = 0; i < quads.size(); i++) {
+            open += depth[i];
+            inLoop[i] = open > 0;
+        }
+        return inLoop;
+    }
+}
+
+int Inliner::costOf(const TACFunction& function) {
+    int cost = 0;
+    for (const auto& quad : function.quads) cost += quad.op != Op::Label && quad.op != Op::Param;
+    return cost;
+}
+
+void Inliner::run(TACProgram& program) {
+    CallGraph graph = CallGraph::build(program);
+    for (const auto& component : graph.components) {
+        for (int f : component) inlineInto(program, graph, f);
+    }
+}
+
+void Inliner::inlineInto(TACProgram& program, const CallGraph& graph, int f) {
+    TACFunction& caller = program.functions[f];
+    unordered_map<uint32_t, int> indexOf;
+    for (size_t i = 0; i < program.functions.size(); i++) indexOf[program.functions[i].name.id] = static_cast<int>(i);
+
+    uint32_t tempCount = 0, labelCount = 0;
+    countNames(caller.quads, tempCount, labelCount);
+    vector<bool> inLoop = loopQuads(caller.quads);
+    bool profiled = profile && profile->covers(caller.name);
+    vector<uint64_t> counts;
+    if (profiled) counts = profile->quadCounts(caller);
+
+    vector<Quad> out;
+    out.reserve(caller.quads.size());
+    for (size_t i = 0; i < caller.quads.size(); i++) {
+        const Quad& quad = caller.quads[i];
+        auto it = quad.op == Op::Call ? indexOf.find(quad.arg1.payload()) : indexOf.end();
+        if (it == indexOf.end() || graph.component[it->second] == graph.component[f]) {
+            out.push_back(quad);
+            continue;
+        }
+        const TACFunction& callee = program.functions[it->second];
+        int cost = costOf(callee);
+        size_t argCount = static_cast<size_t>(quad.arg2.intValue());
+        bool hot = profiled ? profile->isHot(counts[i]) : inLoop[i];
+        bool small = cost <= (hot ? 2 * sizeLimit : sizeLimit) && !(profiled && counts[i] == 0);
+        bool fits = out.size() + (caller.quads.size() - i) + cost <= static_cast<size_t>(growthLimit);
+        bool passed = static_cast<int>(argCount) == callee.paramCount && out.size() >= argCount;
+        for (size_t a = 0; passed && a < argCount; a++) passed = out[out.size() - 1 - a].op == Op::Arg;
+        if (!small || !fits || !passed) {
+            out.push_back(quad);
+            continue;
+        }
+
+        vector<Operand> args(argCount);
+        for (size_t a = argCount; a-- > 0;) {
+            args[a] = out.back().arg1;
+            out.pop_back();
+        }
+        expand(callee, args, quad.result, tempCount, labelCount, out);
+        inlinedCount++;
+    }
+    caller.quads = move(out);
+}
+
+void Inliner::expand(const TACFunction& callee, const vector<Operand>& args, Operand result,
+                     uint32_t& tempCount, uint32_t& labelCount, vector<Quad>& out) {
+    uint32_t calleeTemps = 0, calleeLabels = 0;
+    countNames(callee.quads, calleeTemps, calleeLabels);
+    uint32_t labelBase = labelCount;
+    labelCount += calleeLabels;
+    Operand end = Operand::label(labelCount++);
+
+    // Callee temps and variables each get a fresh caller temp.
+    unordered_map<uint32_t, Operand> renamed;
+    auto rename = [&](Operand operand) {
+        if (operand.isLabel()) return Operand::label(labelBase + operand.payload());
+        if (!operand.isTemp() && !operand.isVar()) return operand;
+        Operand& fresh = renamed[operand.bits];
+        if (fresh.isNone()) fresh = Operand::temp(tempCount++);
+        return fresh;
+    };
+
+    bool jumpsToEnd = false;
+    for (size_t k = 0; k < callee.quads.size(); k++) {
+        const Quad& quad = callee.quads[k];
+        if (quad.op == Op::Param) {
+            out.push_back(Quad(Op::Copy, args[quad.arg1.intValue()], Operand(), rename(quad.result)));
+        } else if (quad.op == Op::Return) {
+            Operand value = quad.arg1.isNone() ? Operand::intConst(0) : rename(quad.arg1);
+            out.push_back(Quad(Op::Copy, value, Operand(), result));
+            if (k + 1 < callee.quads.size()) {
+                out.push_back(Quad(Op::Goto, Operand(), Operand(), end));
+                jumpsToEnd = true;
+            }
+        } else {
+            out.push_back(Quad(quad.op, rename(quad.arg1), rename(quad.arg2), rename(quad.result)));
+        }
+    }
+    if (jumpsToEnd) out.push_back(Quad(Op::Label, Operand(), Operand(), end));
+}
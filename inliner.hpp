@@ -0,0 +1,46 @@
+#ifndef INLINER_HPP
+#define INLINER_HPP
+
+#include <vector>
+#include "tac.hpp"
+#include "call_graph.hpp"
+#include "profile.hpp"
+
+using namespace std;
+
+/**
+ * @brief Bottom-up inliner over a program's TAC, run before SSA. Callees
+ * are processed before their callers, so inlined bodies already have their
+ * own small calls inlined. A call is replaced by a renamed copy of the
+ * callee when the two are not mutually recursive and the callee has at
+ * most `sizeLimit` quads, or twice that for a call inside a loop, where
+ * the call overhead is paid on every iteration. Parameters become copies
+ * of the arguments and returns a copy to the call's result and a jump past
+ * the body. A caller stops taking bodies once it reaches `growthLimit` quads.
+ *
+ * With a profile, measured counts replace the loop guess: calls that never
+ * ran stay calls, and hot ones get the doubled limit.
+ */
+class Inliner {
+private:
+    int sizeLimit;
+    int growthLimit;
+    int inlinedCount = 0;
+    const EdgeProfile* profile = nullptr;
+
+    static int costOf(const TACFunction& function);
+    void inlineInto(TACProgram& program, const CallGraph& graph, int caller);
+    void expand(const TACFunction& callee, const vector<Operand>& args, Operand result,
+                uint32_t& tempCount, uint32_t& labelCount, vector<Quad>& out);
+
+public:
+    explicit Inliner(int sizeLimit = 30, int growthLimit = 2000)
+        : sizeLimit(sizeLimit), growthLimit(growthLimit) {}
+
+    void setProfile(const EdgeProfile* edgeProfile) { profile = edgeProfile; }
+    void run(TACProgram& program);
+
+    int getInlinedCount() const { return inlinedCount; }
+};
+
+#endif
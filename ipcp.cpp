@@ -0,0 +1,254 @@
+#include "ipcp.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    // What one function's quads say about its values and parameters.
+    struct Facts {
+        unordered_map<uint32_t, int> defs;
+        unordered_map<uint32_t, Operand> copied; // value of a copy from a constant
+        vector<Operand> params;
+
+        Facts(const TACFunction& function) : params(function.paramCount) {
+            for (const auto& quad : function.quads) {
+                if (!writesResult(quad.op)) continue;
+                defs[quad.result.bits]++;
+                if (quad.op == Op::Copy && quad.arg1.isConstant()) copied[quad.result.bits] = quad.arg1;
+                if (quad.op == Op::Param && quad.arg1.intValue() < function.paramCount)
+                    params[quad.arg1.intValue()] = quad.result;
+            }
+        }
+
+        int defCount(Operand value) const {
+            auto it = defs.find(value.bits);
+            return it == defs.end() ? 0 : it->second;
+        }
+
+        // The constant `value` always holds, or none.
+        Operand constantOf(Operand value) const {
+            if (value.isConstant()) return value;
+            auto it = copied.find(value.bits);
+            return it != copied.end() && defCount(value) == 1 ? it->second : Operand();
+        }
+
+        // True if `value` is parameter `i` exactly as it came in.
+        bool isParam(size_t i, Operand value) const {
+            return !params[i].isNone() && value == params[i] && defCount(value) == 1;
+        }
+    };
+
+    struct CallSite {
+        int caller;
+        size_t at; // the call quad
+        vector<Operand> args;
+    };
+
+    // Every call to a function of the program, by callee. A callee with a
+    // call whose arguments are not laid out as arg quads is marked opaque.
+    vector<vector<CallSite>> collectCalls(const TACProgram& program, vector<bool>& opaque) {
+        unordered_map<uint32_t, int> indexOf;
+        for (size_t f = 0; f < program.functions.size(); f++) indexOf[program.functions[f].name.id] = static_cast<int>(f);
+
+        vector<vector<CallSite>> calls(program.functions.size());
+        opaque.assign(program.functions.size(), false);
+        for (size_t f = 0; f < program.functions.size(); f++) {
+            const auto& quads = program.functions[f].quads;
+            for (size_t i = 0; i < quads.size(); i++) {
+                if (!isCall(quads[i].op)) continue;
+                auto it = indexOf.find(quads[i].arg1.payload());
+                if (it == indexOf.end()) continue;
+                int callee = it->second;
+                size_t argCount = static_cast<size_t>(quads[i].arg2.intValue());
+                bool laidOut = static_cast<int>(argCount) == program.functions[callee].paramCount && i >= argCount;
+                CallSite site{static_cast<int>(f), i, {}};
+                for (size_t a = 0; laidOut && a < argCount; a++) {
+                    const Quad& arg = quads[i - argCount + a];
+                    laidOut = arg.op == Op::Arg;
+                    site.args.push_back(arg.arg1);
+                }
+                if (!laidOut) opaque[callee] = true;
+                calls[callee].push_back(site);
+            }
+        }
+        return calls;
+    }
+
+    // Where main is, or -1 if the program has none.
+    int mainIndex(const TACProgram& program) {
+        Name mainName("main");
+        for (size_t f = 0; f < program.functions.size(); f++) {
+            if (program.functions[f].name == mainName) return static_cast<int>(f);
+        }
+        return -1;
+    }
+
+    // Parameter i of `callee` as `site` passes it: a constant, none if it
+    // passes the callee's own parameter back, or the arg itself otherwise.
+    Operand argValue(const CallSite& site, int callee, size_t i, const vector<Facts>& facts) {
+        Operand arg = site.args[i];
+        Operand constant = facts[site.caller].constantOf(arg);
+        if (!constant.isNone()) return constant;
+        if (site.caller == callee && facts[callee].isParam(i, arg)) return Operand();
+        return arg;
+    }
+}
+
+void IPCP::run(TACProgram& program) {
+    // Without a main, nothing says which functions are called from outside.
+    if (mainIndex(program) < 0) return;
+    while (propagate(program)) {}
+    specialize(program);
+    removeDeadFunctions(program);
+}
+
+bool IPCP::propagate(TACProgram& program) {
+    vector<bool> opaque;
+    auto calls = collectCalls(program, opaque);
+    vector<Facts> facts(program.functions.begin(), program.functions.end());
+    int mainAt = mainIndex(program);
+
+    bool changed = false;
+    for (size_t f = 0; f < program.functions.size(); f++) {
+        if (static_cast<int>(f) == mainAt || opaque[f] || calls[f].empty()) continue;
+        TACFunction& function = program.functions[f];
+        for (size_t i = 0; i < static_cast<size_t>(function.paramCount); i++) {
+            if (facts[f].params[i].isNone()) continue;
+            Operand agreed;
+            bool varies = false;
+            for (const auto& site : calls[f]) {
+                Operand value = argValue(site, static_cast<int>(f), i, facts);
+                if (value.isNone()) continue;
+                if (!value.isConstant() || (!agreed.isNone() && value != agreed)) varies = true;
+                agreed = value;
+            }
+            if (varies || agreed.isNone()) continue;
+
+            for (auto& quad : function.quads) {
+                if (quad.op != Op::Param || quad.arg1.intValue() != static_cast<int64_t>(i)) continue;
+                quad = Quad(Op::Copy, agreed, Operand(), quad.result);
+            }
+            facts[f].params[i] = Operand();
+            propagatedCount++;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void IPCP::specialize(TACProgram& program) {
+    vector<bool> opaque;
+    auto calls = collectCalls(program, opaque);
+    vector<Facts> facts(program.functions.begin(), program.functions.end());
+    int mainAt = mainIndex(program);
+
+    vector<vector<TACFunction>> copies(program.functions.size()); // by original
+    for (size_t f = 0; f < program.functions.size(); f++) {
+        const TACFunction& function = program.functions[f];
+        int cost = 0;
+        for (const auto& quad : function.quads) cost += quad.op != Op::Label && quad.op != Op::Param;
+        if (static_cast<int>(f) == mainAt || opaque[f] || cost > sizeLimit) continue;
+
+        // A copy only pays if its own recursion keeps the constant.
+        vector<bool> kept(function.paramCount, true);
+        for (const auto& site : calls[f]) {
+            for (size_t i = 0; site.caller == static_cast<int>(f) && i < kept.size(); i++)
+                kept[i] = kept[i] && argValue(site, static_cast<int>(f), i, facts).isNone();
+        }
+
+        // Group the calls by the constants they pass to parameters.
+        vector<vector<Operand>> keys;
+        vector<vector<const CallSite*>> groups;
+        for (const auto& site : calls[f]) {
+            vector<Operand> key(function.paramCount);
+            bool any = false;
+            for (size_t i = 0; i < key.size(); i++) {
+                Operand value = argValue(site, static_cast<int>(f), i, facts);
+                if (!value.isConstant() || !kept[i] || facts[f].params[i].isNone()) continue;
+                key[i] = value;
+                any = true;
+            }
+            if (!any) continue;
+            size_t g = 0;
+            while (g < keys.size() && keys[g] != key) g++;
+            if (g == keys.size()) {
+                if (static_cast<int>(g) == maxSpecializations) continue;
+                keys.push_back(key);
+                groups.emplace_back();
+            }
+            groups[g].push_back(&site);
+        }
+
+        for (size_t g = 0; g < keys.size(); g++) {
+            const auto& key = keys[g];
+            Name name;
+            int n = specializedCount;
+            do {
+                name = Name(function.name.str() + "." + to_string(++n));
+            } while (program.find(name));
+            TACFunction copy{name, function.paramCount, function.quads};
+
+            Operand self = Operand::func(function.name);
+            for (size_t i = 0; i < copy.quads.size(); i++) {
+                Quad& quad = copy.quads[i];
+                if (quad.op == Op::Param && !key[quad.arg1.intValue()].isNone()) {
+                    quad = Quad(Op::Copy, key[quad.arg1.intValue()], Operand(), quad.result);
+                    continue;
+                }
+                // Recursion that passes the fixed parameters back stays here.
+                if (!isCall(quad.op) || quad.arg1 != self || i < key.size()) continue;
+                bool same = true;
+                for (size_t a = 0; same && a < key.size(); a++) {
+                    const Quad& arg = copy.quads[i - key.size() + a];
+                    same = arg.op == Op::Arg && (key[a].isNone() || facts[f].isParam(a, arg.arg1) || arg.arg1 == key[a]);
+                }
+                if (same) quad.arg1 = Operand::func(name);
+            }
+            for (const CallSite* site : groups[g]) program.functions[site->caller].quads[site->at].arg1 = Operand::func(name);
+            copies[f].push_back(move(copy));
+            specializedCount++;
+        }
+    }
+
+    // Each copy goes right after its original.
+    vector<TACFunction> functions;
+    for (size_t f = 0; f < program.functions.size(); f++) {
+        functions.push_back(move(program.functions[f]));
+        for (auto& copy : copies[f]) functions.push_back(move(copy));
+    }
+    program.functions = move(functions);
+}
+
+void IPCP::removeDeadFunctions(TACProgram& program) {
+    CallGraph graph = CallGraph::build(program);
+    vector<bool> reached = graph.reachableFrom(mainIndex(program));
+
+    vector<TACFunction> live;
+    unordered_set<uint32_t> loaded;
+    for (size_t f = 0; f < program.functions.size(); f++) {
+        if (!reached[f]) {
+            removedFunctionCount++;
+            continue;
+        }
+        for (const auto& quad : program.functions[f].quads) {
+            if (quad.op == Op::Load) loaded.insert(quad.arg1.payload());
+        }
+        live.push_back(move(program.functions[f]));
+    }
+    program.functions = move(live);
+
+    // A global nothing loads any more needs neither its stores nor its data.
+    vector<Name> globals;
+    for (Name global : program.globals) {
+        if (loaded.count(global.id)) globals.push_back(global);
+        else removedGlobalCount++;
+    }
+    if (globals.size() == program.globals.size()) return;
+    program.globals = move(globals);
+    for (auto& function : program.functions) {
+        auto& quads = function.quads;
+        quads.erase(remove_if(quads.begin(), quads.end(), [&](const Quad& quad) {
+            return quad.op == Op::Store && !loaded.count(quad.result.payload());
+        }), quads.end());
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef IPCP_HPP
+#define IPCP_HPP
+
+#include <vector>
+#include "tac.hpp"
+#include "call_graph.hpp"
+
+using namespace std;
+
+/**
+ * @brief Interprocedural constant propagation over a whole TACProgram.
+ * Only main is visible outside the program, so every call to any other
+ * function is known. A parameter that every call passes the same
+ * constant is bound to it; recursive calls that pass the parameter back
+ * unchanged agree with any constant. A small function that callers call
+ * with different constants gets a copy per constant combination, as
+ * long as its own recursion passes those parameters back unchanged.
+ * Those copies are called `name.n` and follow their original. Functions
+ * main no longer reaches are then dropped, together with globals nothing
+ * loads and their stores. A program without a main is left alone.
+ */
+class IPCP {
+private:
+    int sizeLimit;
+    int maxSpecializations;
+    int propagatedCount = 0;
+    int specializedCount = 0;
+    int removedFunctionCount = 0;
+    int removedGlobalCount = 0;
+
+    bool propagate(TACProgram& program);
+    void specialize(TACProgram& program);
+    void removeDeadFunctions(TACProgram& program);
+
+public:
+    explicit IPCP(int sizeLimit = 60, int maxSpecializations = 2)
+        : sizeLimit(sizeLimit), maxSpecializations(maxSpecializations) {}
+
+    void run(TACProgram& program);
+
+    int getPropagatedCount() const { return propagatedCount; }
+    int getSpecializedCount() const { return specializedCount; }
+    int getRemovedFunctionCount() const { return removedFunctionCount; }
+    int getRemovedGlobalCount() const { return removedGlobalCount; }
+};
+
+#endif
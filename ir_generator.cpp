@@ -1,105 +1,336 @@
 #include "ir_generator.hpp" 
+#include "tac_io.hpp"
 #include <stdexcept>
 #include <algorithm>
 
+namespace {
+    // Records the names a subtree reads or assigns where none of its own
+    // declarations is in scope. Scopes open where the generator opens them.
+    void collectFreeNames(ASTNode* node, vector<unordered_set<uint32_t>>& scopes, unordered_set<uint32_t>& free) {
+        if (!node) return;
+        auto use = [&](Name name) {
+            for (const auto& scope : scopes) {
+                if (scope.count(name.id)) return;
+            }
+            free.insert(name.id);
+        };
+        switch (node->nodeType) {
+            case NODE_IDENTIFIER:
+                use(static_cast<Identifier*>(node)->name);
+                break;
+            case NODE_BINARY_OP:
+                collectFreeNames(static_cast<BinaryOp*>(node)->left, scopes, free);
+                collectFreeNames(static_cast<BinaryOp*>(node)->right, scopes, free);
+                break;
+            case NODE_UNARY_OP:
+                collectFreeNames(static_cast<UnaryOp*>(node)->operand, scopes, free);
+                break;
+            case NODE_ASSIGNMENT:
+                use(static_cast<Assignment*>(node)->ident);
+                collectFreeNames(static_cast<Assignment*>(node)->value, scopes, free);
+                break;
+            case NODE_FUNC_CALL:
+                for (auto arg : static_cast<FunctionCall*>(node)->args) collectFreeNames(arg, scopes, free);
+                break;
+            case NODE_VAR_DECL:
+                collectFreeNames(static_cast<VarDecl*>(node)->expr, scopes, free);
+                scopes.back().insert(static_cast<VarDecl*>(node)->ident.id);
+                break;
+            case NODE_EXPR_STMT:
+                collectFreeNames(static_cast<ExprStmt*>(node)->expr, scopes, free);
+                break;
+            case NODE_RETURN:
+                collectFreeNames(static_cast<ReturnStmt*>(node)->expr, scopes, free);
+                break;
+            case NODE_BLOCK:
+                scopes.emplace_back();
+                for (auto stmt : static_cast<Block*>(node)->stmts) collectFreeNames(stmt, scopes, free);
+                scopes.pop_back();
+                break;
+            case NODE_IF: {
+                auto* ifStmt = static_cast<IfStmt*>(node);
+                collectFreeNames(ifStmt->condition, scopes, free);
+                collectFreeNames(ifStmt->thenBranch, scopes, free);
+                collectFreeNames(ifStmt->elseBranch, scopes, free);
+                break;
+            }
+            case NODE_WHILE:
+                collectFreeNames(static_cast<WhileStmt*>(node)->condition, scopes, free);
+                collectFreeNames(static_cast<WhileStmt*>(node)->body, scopes, free);
+                break;
+            case NODE_FOR: {
+                auto* forStmt = static_cast<ForStmt*>(node);
+                scopes.emplace_back();
+                collectFreeNames(forStmt->init, scopes, free);
+                collectFreeNames(forStmt->condition, scopes, free);
+                collectFreeNames(forStmt->update, scopes, free);
+                collectFreeNames(forStmt->body, scopes, free);
+                scopes.pop_back();
+                break;
+            }
+            case NODE_FUNC_DECL: {
+                auto* decl = static_cast<FunctionDecl*>(node);
+                scopes.emplace_back();
+                for (const auto& param : decl->params) scopes.back().insert(param.name.id);
+                collectFreeNames(decl->body, scopes, free);
+                scopes.pop_back();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
 
-string IRGenerator::newTemp() {
-    return "_t" + to_string(tempCounter++);
+
+Operand IRGenerator::newTemp() {
+    return Operand::temp(tempCounter++);
 }
 
-string IRGenerator::newLabel() {
-    return "_L" + to_string(labelCounter++);
+Operand IRGenerator::newLabel() {
+    return Operand::label(labelCounter++);
 }
 
 void IRGenerator::emit(const Quad& quad) {
     quads.push_back(quad);
 }
 
-void IRGenerator::emitLabel(const string& label) {
-    emit(Quad("label", "", "", "", label));
+void IRGenerator::emitLabel(Operand label) {
+    emit(Quad(Op::Label, Operand(), Operand(), label));
 }
 
-string IRGenerator::tokenTypeToOp(TokenType type) {
+/**
+ * @brief What `name` denotes where code is being generated: a global or a
+ * variable of the current function.
+ */
+Operand IRGenerator::lookup(Name name) const {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        auto it = scope->find(name.id);
+        if (it != scope->end()) return it->second;
+    }
+    return Operand::var(name); // undeclared, which ScopeAnalyzer reports
+}
+
+/**
+ * @brief Binds `name` in the innermost scope to a new variable. The first
+ * declaration of a name in a function keeps it; later ones, which shadow
+ * or follow it, are numbered.
+ */
+Operand IRGenerator::declare(Name name) {
+    int n = declarations[name.id]++;
+    Operand variable = Operand::var(n == 0 ? name : Name(name.str() + "." + to_string(n)));
+    scopes.back()[name.id] = variable;
+    return variable;
+}
+
+void IRGenerator::beginFunction() {
+    quads.clear();
+    scopes.assign(1, {});
+    declarations.clear();
+    tempCounter = 0;
+    labelCounter = 0;
+    while (!breakTargets.empty()) breakTargets.pop();
+    while (!continueTargets.empty()) continueTargets.pop();
+}
+
+/**
+ * @brief Closes the current function, returning 0 if control can reach its
+ * end, and adds it to the program.
+ */
+void IRGenerator::endFunction(Name name, int paramCount) {
+    if (quads.empty() || quads.back().op != Op::Return) {
+        emit(Quad(Op::Return, Operand::intConst(0)));
+    }
+    TACFunction function;
+    function.name = name;
+    function.paramCount = paramCount;
+    function.quads = move(quads);
+    program.functions.push_back(move(function));
+    quads.clear();
+}
+
+Op IRGenerator::tokenTypeToOp(TokenType type) {
     switch (type) {
-        case T_PLUS_RL: return "+";
-        case T_MINUS_RL: return "-";
-        case T_MUL_RL: return "*";
-        case T_DIV_RL: return "/";
-        case T_MOD_RL: return "%";
-        case T_LESS_THAN_RL: return "<";
-        case T_GREATER_THAN_RL: return ">";
-        case T_LESS_EQUAL_RL: return "<=";
-        case T_GREATER_EQUAL_RL: return ">=";
-        case T_EQUALSOP_RL: return "==";
-        case T_NOT_EQUALS_RL: return "!=";
-        case T_AND_LOGICAL_RL: return "&&"; 
-        case T_OR_LOGICAL_RL: return "||";  
-        default: return "op_unhandled";
-    }
-}
-
-string IRGenerator::generateExpression(Expr* expr) {
-    if (!expr) return "";
+        case T_PLUS_RL: return Op::Add;
+        case T_MINUS_RL: return Op::Sub;
+        case T_MUL_RL: return Op::Mul;
+        case T_DIV_RL: return Op::Div;
+        case T_MOD_RL: return Op::Mod;
+        case T_AND_BIT_RL: return Op::BitAnd;
+        case T_OR_BIT_RL: return Op::BitOr;
+        case T_XOR_BIT_RL: return Op::BitXor;
+        case T_LESS_THAN_RL: return Op::Lt;
+        case T_GREATER_THAN_RL: return Op::Gt;
+        case T_LESS_EQUAL_RL: return Op::Le;
+        case T_GREATER_EQUAL_RL: return Op::Ge;
+        case T_EQUALSOP_RL: return Op::Eq;
+        case T_NOT_EQUALS_RL: return Op::Ne;
+        case T_AND_LOGICAL_RL: return Op::And; 
+        case T_OR_LOGICAL_RL: return Op::Or;  
+        default: throw runtime_error("Unhandled binary operator in IR generation.");
+    }
+}
+
+Operand IRGenerator::generateExpression(Expr* expr) {
+    if (!expr) return Operand();
 
     switch (expr->nodeType) {
         case NODE_INT_LIT:
-            return to_string(static_cast<IntLiteral*>(expr)->value);
+            return Operand::intConst(static_cast<IntLiteral*>(expr)->value);
         case NODE_FLOAT_LIT:
-            return to_string(static_cast<FloatLiteral*>(expr)->value);
+            return Operand::floatConst(static_cast<FloatLiteral*>(expr)->value);
         case NODE_STRING_LIT:
-            return static_cast<StringLiteral*>(expr)->value;
+            return Operand::str(Name(static_cast<StringLiteral*>(expr)->value));
         case NODE_BOOL_LIT:
-            return static_cast<BoolLiteral*>(expr)->value ? "true" : "false";
-        case NODE_IDENTIFIER:
-            return static_cast<Identifier*>(expr)->name;
+            return Operand::boolConst(static_cast<BoolLiteral*>(expr)->value);
+        case NODE_IDENTIFIER: {
+            Operand variable = lookup(static_cast<Identifier*>(expr)->name);
+            if (variable.kind() != OperandKind::Global) return variable;
+            Operand value = newTemp();
+            emit(Quad(Op::Load, variable, Operand(), value));
+            return value;
+        }
         case NODE_BINARY_OP:
             return generateBinaryOp(static_cast<BinaryOp*>(expr));
         case NODE_UNARY_OP:
             return generateUnaryOp(static_cast<UnaryOp*>(expr));
         case NODE_ASSIGNMENT:
             return generateAssignment(static_cast<Assignment*>(expr));
-        case NODE_FUNC_CALL: {
-            for (auto arg : static_cast<FunctionCall*>(expr)->args) {
-                generateExpression(arg); 
-            }
-            string funcTemp = newTemp();
-            emit(Quad("call", static_cast<FunctionCall*>(expr)->name, "", funcTemp));
-            return funcTemp;
-        } 
+        case NODE_FUNC_CALL:
+            return generateCall(static_cast<FunctionCall*>(expr));
         default:
             throw runtime_error("Unhandled expression type in IR generation.");
     }
 }
 
-string IRGenerator::generateBinaryOp(BinaryOp* op) {
-    string left = generateExpression(op->left);
-    string right = generateExpression(op->right);
-    string result = newTemp();
-    string opStr = tokenTypeToOp(op->op);
+Operand IRGenerator::generateBinaryOp(BinaryOp* op) {
+    if (op->op == T_AND_LOGICAL_RL || op->op == T_OR_LOGICAL_RL) {
+        return generateLogicalOp(op);
+    }
+    Operand left = generateExpression(op->left);
+    Operand right = generateExpression(op->right);
+    Operand result = newTemp();
+
+    emit(Quad(tokenTypeToOp(op->op), left, right, result));
+    return result;
+}
+
+/**
+ * @brief Lowers `a && b` / `a || b` used as a value into control flow that
+ * writes sahi or galat to one result temp.
+ */
+Operand IRGenerator::generateLogicalOp(BinaryOp* op) {
+    Operand result = newTemp();
+    Operand falseLabel = newLabel();
+    Operand endLabel = newLabel();
+    generateJumpIfFalse(op, falseLabel);
+    emit(Quad(Op::Copy, Operand::boolConst(true), Operand(), result));
+    emit(Quad(Op::Goto, Operand(), Operand(), endLabel));
+    emitLabel(falseLabel);
+    emit(Quad(Op::Copy, Operand::boolConst(false), Operand(), result));
+    emitLabel(endLabel);
+    return result;
+}
 
-    emit(Quad(opStr, left, right, result));
+/**
+ * @brief Evaluates every argument first, so that calls nested in them are
+ * done, then passes them with `arg` quads right before the call.
+ */
+Operand IRGenerator::generateCall(FunctionCall* call) {
+    vector<Operand> args;
+    for (auto arg : call->args) {
+        args.push_back(generateExpression(arg));
+    }
+    for (Operand arg : args) {
+        emit(Quad(Op::Arg, arg));
+    }
+    Operand result = newTemp();
+    emit(Quad(Op::Call, Operand::func(call->name), Operand::intConst(static_cast<int64_t>(args.size())), result));
     return result;
 }
 
-string IRGenerator::generateUnaryOp(UnaryOp* op) {
-    string operand = generateExpression(op->operand);
-    string result = newTemp();
+void IRGenerator::generateJumpIfFalse(Expr* cond, Operand falseLabel) {
+    if (cond->nodeType == NODE_BOOL_LIT) {
+        if (!static_cast<BoolLiteral*>(cond)->value) emit(Quad(Op::Goto, Operand(), Operand(), falseLabel));
+        return;
+    }
+    if (cond->nodeType == NODE_UNARY_OP && static_cast<UnaryOp*>(cond)->op == T_NOT_RL) {
+        generateJumpIfTrue(static_cast<UnaryOp*>(cond)->operand, falseLabel);
+        return;
+    }
+    if (cond->nodeType == NODE_BINARY_OP) {
+        auto* bin = static_cast<BinaryOp*>(cond);
+        if (bin->op == T_AND_LOGICAL_RL) {
+            generateJumpIfFalse(bin->left, falseLabel);
+            generateJumpIfFalse(bin->right, falseLabel);
+            return;
+        }
+        if (bin->op == T_OR_LOGICAL_RL) {
+            Operand trueLabel = newLabel();
+            generateJumpIfTrue(bin->left, trueLabel);
+            generateJumpIfFalse(bin->right, falseLabel);
+            emitLabel(trueLabel);
+            return;
+        }
+    }
+    emit(Quad(Op::IfFalse, generateExpression(cond), Operand(), falseLabel));
+}
+
+void IRGenerator::generateJumpIfTrue(Expr* cond, Operand trueLabel) {
+    if (cond->nodeType == NODE_BOOL_LIT) {
+        if (static_cast<BoolLiteral*>(cond)->value) emit(Quad(Op::Goto, Operand(), Operand(), trueLabel));
+        return;
+    }
+    if (cond->nodeType == NODE_UNARY_OP && static_cast<UnaryOp*>(cond)->op == T_NOT_RL) {
+        generateJumpIfFalse(static_cast<UnaryOp*>(cond)->operand, trueLabel);
+        return;
+    }
+    if (cond->nodeType == NODE_BINARY_OP) {
+        auto* bin = static_cast<BinaryOp*>(cond);
+        if (bin->op == T_OR_LOGICAL_RL) {
+            generateJumpIfTrue(bin->left, trueLabel);
+            generateJumpIfTrue(bin->right, trueLabel);
+            return;
+        }
+        if (bin->op == T_AND_LOGICAL_RL) {
+            Operand falseLabel = newLabel();
+            generateJumpIfFalse(bin->left, falseLabel);
+            generateJumpIfTrue(bin->right, trueLabel);
+            emitLabel(falseLabel);
+            return;
+        }
+    }
+    // TAC only has if_false, so step over an unconditional jump.
+    Operand skipLabel = newLabel();
+    emit(Quad(Op::IfFalse, generateExpression(cond), Operand(), skipLabel));
+    emit(Quad(Op::Goto, Operand(), Operand(), trueLabel));
+    emitLabel(skipLabel);
+}
+
+Operand IRGenerator::generateUnaryOp(UnaryOp* op) {
+    Operand operand = generateExpression(op->operand);
+    Operand result = newTemp();
 
     if (op->op == T_MINUS_RL) {
-        emit(Quad("neg", operand, "", result));
+        emit(Quad(Op::Neg, operand, Operand(), result));
     } else if (op->op == T_NOT_RL) {
-        emit(Quad("not", operand, "", result));
+        emit(Quad(Op::Not, operand, Operand(), result));
     } else {
         throw runtime_error("Unhandled unary operator in IR generation.");
     }
     return result;
 }
 
-string IRGenerator::generateAssignment(Assignment* assign) {
-    string value = generateExpression(assign->value);
-    
-    emit(Quad("copy", value, "", assign->ident)); 
-    return assign->ident; 
+Operand IRGenerator::generateAssignment(Assignment* assign) {
+    Operand value = generateExpression(assign->value);
+    Operand target = lookup(assign->ident);
+    if (target.kind() == OperandKind::Global) {
+        emit(Quad(Op::Store, value, Operand(), target));
+        return value;
+    }
+
+    emit(Quad(Op::Copy, value, Operand(), target)); 
+    return target; 
 }
 
 
@@ -122,6 +353,9 @@ void IRGenerator::generateStatement(Stmt* stmt) {
         case NODE_WHILE:
             generateWhileStmt(static_cast<WhileStmt*>(stmt));
             break;
+        case NODE_FOR:
+            generateForStmt(static_cast<ForStmt*>(stmt));
+            break;
         case NODE_BREAK:
             generateBreakStmt(static_cast<BreakStmt*>(stmt));
             break;
@@ -136,28 +370,52 @@ void IRGenerator::generateStatement(Stmt* stmt) {
     }
 }
 
+/**
+ * @brief The initializer is evaluated before the name is bound, so it
+ * still sees what the name meant outside, as ASTInterpreter does. Without
+ * one, an int, float or bool starts at zero, which is also what the
+ * interpreter folds it to. A top-level declaration of a shared variable
+ * binds the global itself.
+ */
 void IRGenerator::generateVarDecl(VarDecl* decl) {
+    Operand value;
     if (decl->expr) {
-        string value = generateExpression(decl->expr);
-        emit(Quad("copy", value, "", decl->ident));
+        value = generateExpression(decl->expr);
+    } else if (decl->type == T_INT_RL || decl->type == T_GINTI_RL) {
+        value = Operand::intConst(0);
+    } else if (decl->type == T_FLOAT_RL) {
+        value = Operand::floatConst(0.0);
+    } else if (decl->type == T_BOOL_RL) {
+        value = Operand::boolConst(false);
+    }
+    Operand target;
+    auto global = globals.find(decl->ident.id);
+    if (scopes.size() == 1 && global != globals.end()) {
+        target = global->second;
+        scopes.back()[decl->ident.id] = target;
+    } else {
+        target = declare(decl->ident);
     }
+    if (value.isNone()) return;
+    emit(Quad(target.kind() == OperandKind::Global ? Op::Store : Op::Copy, value, Operand(), target));
 }
 
 void IRGenerator::generateBlock(Block* block) {
+    scopes.emplace_back();
     for (auto stmt : block->stmts) {
         generateStatement(stmt);
     }
+    scopes.pop_back();
 }
 
 void IRGenerator::generateIfStmt(IfStmt* ifStmt) {
-    string condResult = generateExpression(ifStmt->condition);
-    string endLabel = newLabel();
-    string elseLabel = newLabel();
-    emit(Quad("if_false", condResult, "", "", ifStmt->elseBranch ? elseLabel : endLabel));
+    Operand endLabel = newLabel();
+    Operand elseLabel = newLabel();
+    generateJumpIfFalse(ifStmt->condition, ifStmt->elseBranch ? elseLabel : endLabel);
     generateStatement(ifStmt->thenBranch);
     
     if (ifStmt->elseBranch) {
-        emit(Quad("goto", "", "", "", endLabel));
+        emit(Quad(Op::Goto, Operand(), Operand(), endLabel));
         emitLabel(elseLabel);
         generateStatement(ifStmt->elseBranch);
     }
@@ -168,27 +426,65 @@ void IRGenerator::generateIfStmt(IfStmt* ifStmt) {
  * @brief Generates TAC for a WhileStmt, managing loop context.
  */
 void IRGenerator::generateWhileStmt(WhileStmt* whileStmt) {
-    string loopStartLabel = newLabel(); 
-    string loopEndLabel = newLabel();  
+    Operand loopStartLabel = newLabel(); 
+    Operand loopEndLabel = newLabel();  
 
     breakTargets.push(loopEndLabel);
     continueTargets.push(loopStartLabel);
     emitLabel(loopStartLabel);
-    string condResult = generateExpression(whileStmt->condition);
-    emit(Quad("if_false", condResult, "", "", loopEndLabel));
+    generateJumpIfFalse(whileStmt->condition, loopEndLabel);
     generateStatement(whileStmt->body); 
-    emit(Quad("goto", "", "", "", loopStartLabel));
+    emit(Quad(Op::Goto, Operand(), Operand(), loopStartLabel));
     emitLabel(loopEndLabel);
     continueTargets.pop();
     breakTargets.pop();
 }
 
+/**
+ * @brief Generates TAC for a ForStmt; `continue` goes to the update.
+ */
+void IRGenerator::generateForStmt(ForStmt* forStmt) {
+    Operand loopStartLabel = newLabel();
+    Operand updateLabel = newLabel();
+    Operand loopEndLabel = newLabel();
+
+    scopes.emplace_back();
+    generateStatement(forStmt->init);
+    breakTargets.push(loopEndLabel);
+    continueTargets.push(updateLabel);
+    emitLabel(loopStartLabel);
+    if (forStmt->condition) generateJumpIfFalse(forStmt->condition, loopEndLabel);
+    generateStatement(forStmt->body);
+    emitLabel(updateLabel);
+    generateExpression(forStmt->update);
+    emit(Quad(Op::Goto, Operand(), Operand(), loopStartLabel));
+    emitLabel(loopEndLabel);
+    continueTargets.pop();
+    breakTargets.pop();
+    scopes.pop_back();
+}
+
+/**
+ * @brief Binds each parameter with a `param` quad, then lowers the body.
+ * The function sees the globals, then its parameters.
+ */
+void IRGenerator::generateFunctionDecl(FunctionDecl* decl) {
+    beginFunction();
+    scopes.front() = globals;
+    scopes.emplace_back();
+    for (size_t i = 0; i < decl->params.size(); i++) {
+        emit(Quad(Op::Param, Operand::intConst(static_cast<int64_t>(i)), Operand(), declare(decl->params[i].name)));
+    }
+    generateStatement(decl->body);
+    endFunction(decl->name, static_cast<int>(decl->params.size()));
+}
+
 /**
  * @brief Generates TAC for a BreakStmt. Jumps to the current loop's exit label.
  */
 void IRGenerator::generateBreakStmt(BreakStmt* breakStmt) {
     if (breakTargets.empty()) return; 
-    emit(Quad("goto", "", "", "", breakTargets.top()));
+    emit(Quad(Op::Goto, Operand(), Operand(), breakTargets.top()));
 }
 
 /**
@@ -196,26 +492,61 @@ void IRGenerator::generateBreakStmt(BreakStmt* breakStmt) {
  */
 void IRGenerator::generateContinueStmt(ContinueStmt* continueStmt) {
     if (continueTargets.empty()) return;
-    emit(Quad("goto", "", "", "", continueTargets.top()));
+    emit(Quad(Op::Goto, Operand(), Operand(), continueTargets.top()));
 }
 
 void IRGenerator::generateReturnStmt(ReturnStmt* returnStmt) {
     if (returnStmt->expr) {
-        string result = generateExpression(returnStmt->expr);
-        emit(Quad("return", result, "", ""));
+        Operand result = generateExpression(returnStmt->expr);
+        emit(Quad(Op::Return, result));
     } else {
-        emit(Quad("return", "", "", ""));
+        emit(Quad(Op::Return));
     }
 }
 
-vector<Quad> IRGenerator::generate(const vector<Stmt*>& program) {
-    quads.clear();
-    tempCounter = 0;
-    labelCounter = 0;
-    while (!breakTargets.empty()) breakTargets.pop();
-    while (!continueTargets.empty()) continueTargets.pop();
+TACProgram IRGenerator::generate(const vector<Stmt*>& statements) {
+    program = TACProgram();
+    globals.clear();
+
+    // A top-level variable is global if some function uses it where no
+    // declaration of its own is in scope.
+    unordered_set<uint32_t> topLevel, shared;
+    for (auto stmt : statements) {
+        if (stmt->nodeType == NODE_VAR_DECL) topLevel.insert(static_cast<VarDecl*>(stmt)->ident.id);
+    }
+    for (auto stmt : statements) {
+        if (stmt->nodeType != NODE_FUNC_DECL) continue;
+        vector<unordered_set<uint32_t>> scopes(1);
+        unordered_set<uint32_t> free;
+        collectFreeNames(stmt, scopes, free);
+        for (uint32_t name : free) {
+            if (topLevel.count(name)) shared.insert(name);
+        }
+    }
+    for (auto stmt : statements) {
+        if (stmt->nodeType != NODE_VAR_DECL) continue;
+        Name name = static_cast<VarDecl*>(stmt)->ident;
+        if (shared.count(name.id) && !globals.count(name.id)) {
+            program.globals.push_back(name);
+            globals[name.id] = Operand::global(name);
+        }
+    }
 
-    for (auto stmt : program) {
+    Name mainName("main");
+    for (auto stmt : statements) {
+        if (stmt->nodeType != NODE_FUNC_DECL) continue;
+        auto* decl = static_cast<FunctionDecl*>(stmt);
+        try {
+            if (decl->name == mainName) throw runtime_error("fn main clashes with the top-level program.");
+            generateFunctionDecl(decl);
+        } catch (const runtime_error& e) {
+            cerr << "IR Generation Error: " << e.what() << endl;
+        }
+    }
+
+    beginFunction();
+    for (auto stmt : statements) {
+        if (stmt->nodeType == NODE_FUNC_DECL) continue;
         try {
             generateStatement(stmt);
         } catch (const runtime_error& e) {
@@ -223,19 +554,14 @@ vector<Quad> IRGenerator::generate(const vector<Stmt*>& program) {
             break;
         }
     }
+    endFunction(mainName, 0);
 
-    return quads;
+    return program;
 }
 
 void IRGenerator::printIRCode() { 
     cout << "# Intermediate Representation (TAC)" << endl;
     cout << "--- Generated Three-Address Code (TAC) ---" << endl;
-    for (const auto& quad : quads) {
-        if (quad.op == "label") {
-            cout << quad.result << ":" << endl;
-        } else {
-            cout << quad.toString() << endl;
-        }
-    }
+    writeTACText(cout, program);
     cout << endl;
-}
\ No newline at end of file
+}
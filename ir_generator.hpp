@@ -6,66 +6,59 @@
 #include <vector>
 #include <stack>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 #include "ast.hpp"
 #include "Utilities/token_types.hpp"
+#include "Utilities/symbol_interner.hpp"
+#include "tac.hpp"
 
 using namespace std;
 
 /**
- * @brief Represents a single Three-Address Code instruction (Quadruple).
+ * @brief Lowers the AST to TAC, one TACFunction per `fn` plus `main` for
+ * the top-level statements. Top-level variables that some function refers
+ * to become globals; every other variable is local to its function.
+ * Names are resolved scope by scope as ScopeAnalyzer does, and a
+ * declaration of a name the function already declared gets a variable of
+ * its own, `name.n`.
  */
-struct Quad {
-    string op;    
-    string arg1;  
-    string arg2;  
-    string result; 
-
-    Quad(string o, string a1, string a2, string r) : op(o), arg1(a1), arg2(a2), result(r) {}
-    Quad(string o, string a1, string a2, string r, string target) : op(o), arg1(a1), arg2(a2), result(r) {
-        if (o == "goto" || o == "if_false") result = target;
-        if (o == "label") result = target;
-    }
-
-    string toString() const {
-        if (op == "copy") {
-            return result + " = " + arg1;
-        } else if (op == "goto") {
-            return "goto " + result;
-        } else if (op == "if_false") {
-            return "if_false " + arg1 + " goto " + result;
-        } else if (op == "+" || op == "-" || op == "*" || op == "/" || op == "==" || op == "<" || op == ">" || op == "<=" || op == ">=" || op == "!=") {
-            return result + " = " + arg1 + " " + op + " " + arg2;
-        } else if (op == "neg" || op == "not") {
-             return result + " = " + op + " " + arg1;
-        } else if (op == "return") {
-            return "return " + arg1;
-        }
-        return "/* Unhandled Quad: " + op + " " + arg1 + " " + arg2 + " " + result + " */";
-    }
-};
-
-
 class IRGenerator {
 private:
-    vector<Quad> quads;
+    TACProgram program;
+    vector<Quad> quads; // body of the function being generated
     int tempCounter = 0;
     int labelCounter = 0;
+    unordered_map<uint32_t, Operand> globals;           // shared top-level variables, by name
+    vector<unordered_map<uint32_t, Operand>> scopes;     // what each name denotes, innermost last
+    unordered_map<uint32_t, int> declarations;           // per name, in the current function
 
-    stack<string> breakTargets;  
-    stack<string> continueTargets; 
+    stack<Operand> breakTargets;  
+    stack<Operand> continueTargets; 
 
     // Helper functions
-    string newTemp();
-    string newLabel();
+    Operand newTemp();
+    Operand newLabel();
     void emit(const Quad& quad);
-    void emitLabel(const string& label);
-    string tokenTypeToOp(TokenType type);
+    void emitLabel(Operand label);
+    Op tokenTypeToOp(TokenType type);
+    Operand lookup(Name name) const;
+    Operand declare(Name name);
+    void beginFunction();
+    void endFunction(Name name, int paramCount);
 
     // Expression generation
-    string generateExpression(Expr* expr);
-    string generateBinaryOp(BinaryOp* op);
-    string generateUnaryOp(UnaryOp* op);
-    string generateAssignment(Assignment* assign);
+    Operand generateExpression(Expr* expr);
+    Operand generateBinaryOp(BinaryOp* op);
+    Operand generateUnaryOp(UnaryOp* op);
+    Operand generateAssignment(Assignment* assign);
+    Operand generateLogicalOp(BinaryOp* op);
+    Operand generateCall(FunctionCall* call);
+
+    // Branch context: jump to the label if the condition has that outcome,
+    // otherwise fall through. && and || skip their right operand as needed.
+    void generateJumpIfFalse(Expr* cond, Operand falseLabel);
+    void generateJumpIfTrue(Expr* cond, Operand trueLabel);
 
     // Statement generation
     void generateStatement(Stmt* stmt);
@@ -73,6 +66,8 @@ private:
     void generateBlock(Block* block);
     void generateIfStmt(IfStmt* ifStmt);
     void generateWhileStmt(WhileStmt* whileStmt);
+    void generateForStmt(ForStmt* forStmt);
+    void generateFunctionDecl(FunctionDecl* decl);
     void generateBreakStmt(BreakStmt* breakStmt);
     void generateContinueStmt(ContinueStmt* continueStmt);
     void generateReturnStmt(ReturnStmt* returnStmt);
@@ -80,7 +75,7 @@ private:
 
 public:
     IRGenerator() = default;
-    vector<Quad> generate(const vector<Stmt*>& program);
+    TACProgram generate(const vector<Stmt*>& program);
     void printIRCode(); 
 };
 
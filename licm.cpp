@@ -0,0 +1,71 @@
+#include "licm.hpp"
+
+bool LoopInvariantCodeMotion::isHoistable(const Quad& quad) {
+    // Calls may have effects, globals may be changed by them, and variables
+    // still outside SSA form likewise, so none is moved or treated as invariant.
+    if (!writesResult(quad.op) || touchesMemory(quad.op) || !quad.result.isTemp()) return false;
+    if (quad.arg1.isVar() || quad.arg2.isVar()) return false;
+    // Division may trap; only move it when the divisor is a nonzero constant.
+    if (quad.op == Op::Div || quad.op == Op::Mod) {
+        Operand divisor = quad.arg2;
+        if (divisor.kind() == OperandKind::Int) return divisor.intValue() != 0 && divisor.intValue() != -1;
+        if (divisor.kind() == OperandKind::Float) return divisor.floatValue() != 0.0;
+        return false;
+    }
+    return true;
+}
+
+void LoopInvariantCodeMotion::run(CFG& cfg) {
+    // Preheaders first: inserting blocks renumbers the CFG.
+    vector<Operand> headers;
+    for (const auto& loop : cfg.naturalLoops()) headers.push_back(cfg.blocks[loop.header].label);
+    for (Operand label : headers) {
+        int header = cfg.blockForLabel(label);
+        if (header >= 0) cfg.ensurePreheader(header);
+    }
+
+    for (const auto& loop : cfg.naturalLoops()) {
+        loopCount++;
+        int preheader = cfg.ensurePreheader(loop.header);
+        if (preheader >= 0) hoist(cfg, loop, preheader);
+    }
+}
+
+void LoopInvariantCodeMotion::hoist(CFG& cfg, const Loop& loop, int preheader) {
+    vector<char> definedInLoop(cfg.tempCount, 0);
+    for (int b : loop.blocks) {
+        for (const auto& phi : cfg.blocks[b].phis) definedInLoop[phi.result.payload()] = 1;
+        for (const auto& quad : cfg.blocks[b].quads) {
+            if (writesResult(quad.op) && quad.result.isTemp()) definedInLoop[quad.result.payload()] = 1;
+        }
+    }
+    auto invariant = [&](Operand operand) {
+        return !operand.isTemp() || operand.payload() >= definedInLoop.size() || !definedInLoop[operand.payload()];
+    };
+
+    // Reverse postorder sees a definition before the uses it dominates, so
+    // one sweep finds chains of invariant quads.
+    vector<Quad> hoisted;
+    for (int b : cfg.reversePostorder()) {
+        if (!loop.contains(b)) continue;
+        auto& quads = cfg.blocks[b].quads;
+        vector<Quad> kept;
+        for (const auto& quad : quads) {
+            if (isHoistable(quad) && invariant(quad.arg1) && invariant(quad.arg2)) {
+                definedInLoop[quad.result.payload()] = 0;
+                hoisted.push_back(quad);
+            } else {
+                kept.push_back(quad);
+            }
+        }
+        if (kept.size() != quads.size()) cfg.invalidateBlock(b);
+        quads = move(kept);
+    }
+    if (hoisted.empty()) return;
+
+    auto& target = cfg.blocks[preheader].quads;
+    auto at = cfg.blocks[preheader].terminator() ? target.end() - 1 : target.end();
+    target.insert(at, hoisted.begin(), hoisted.end());
+    cfg.invalidateBlock(preheader);
+    hoistedCount += static_cast<int>(hoisted.size());
+}
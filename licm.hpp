@@ -0,0 +1,29 @@
+#ifndef LICM_HPP
+#define LICM_HPP
+
+#include <vector>
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Loop-invariant code motion over a CFG in SSA form. Every natural
+ * loop gets a preheader, and pure computations whose operands are constants
+ * or defined outside the loop move into it, innermost loops first.
+ */
+class LoopInvariantCodeMotion {
+private:
+    int loopCount = 0;
+    int hoistedCount = 0;
+
+    static bool isHoistable(const Quad& quad);
+    void hoist(CFG& cfg, const Loop& loop, int preheader);
+
+public:
+    void run(CFG& cfg);
+
+    int getLoopCount() const { return loopCount; }
+    int getHoistedCount() const { return hoistedCount; }
+};
+
+#endif
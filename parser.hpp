@@ -70,7 +70,7 @@ private:
   {
     cerr << "Parse Error at line " << currentToken().line
          << ": " << msg << endl;
-    cerr << "Got token: " << currentToken().value << endl;
+    cerr << "Got token: " << currentToken().text() << endl;
     exit(1);
   }
 
@@ -80,7 +80,7 @@ private:
     if (tok.type == T_INT_RLLIT)
     {
       nextToken();
-      return new IntLiteral(stoi(tok.value));
+      return new IntLiteral(stoll(tok.value));
     }
     if (tok.type == T_FLOAT_RLLIT)
     {
@@ -99,7 +99,7 @@ private:
     }
     if (tok.type == T_IDENTIFIER_RL)
     {
-      string name = tok.value;
+      Name name = tok.name;
       nextToken();
       if (isToken(T_PARENL_RL))
       {
@@ -230,7 +230,7 @@ private:
         error("Can only assign to variables");
       }
       Identifier *id = (Identifier *)left;
-      string name = id->name;
+      Name name = id->name;
       delete left; 
 
       nextToken();
@@ -252,7 +252,7 @@ private:
     {
       error("Expected variable name");
     }
-    string name = getToken().value;
+    Name name = getToken().name;
     Expr *init = nullptr;
     if (eatToken(T_ASSIGNOP_RL))
     {
@@ -452,7 +452,7 @@ private:
     {
       error("Expected function name");
     }
-    string name = getToken().value;
+    Name name = getToken().name;
 
     if (!eatToken(T_PARENL_RL))
     {
@@ -472,7 +472,7 @@ private:
       {
         error("Expected parameter name");
       }
-      string paramName = getToken().value;
+      Name paramName = getToken().name;
 
       params.push_back(Param(paramType, paramName));
 
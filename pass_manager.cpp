@@ -0,0 +1,322 @@
+#include "pass_manager.hpp"
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+#include "cfg.hpp"
+#include "ssa.hpp"
+#include "sccp.hpp"
+#include "gvn.hpp"
+#include "dce.hpp"
+#include "licm.hpp"
+#include "strength_reduction.hpp"
+#include "simplify_cfg.hpp"
+#include "inliner.hpp"
+#include "tail_calls.hpp"
+#include "unroll.hpp"
+#include "ipcp.hpp"
+#include "temp_compaction.hpp"
+#include "block_layout.hpp"
+#include "profile.hpp"
+#include "verifier.hpp"
+
+namespace {
+    // The IR a pass works on.
+    enum class Form { Quads, CFG, SSA };
+
+    // One step of a pipeline: a fresh pass object, run over the program or
+    // over each function's CFG, and a line of its counters afterwards.
+    // A per-function pass may also describe what it just did to one
+    // function; an empty detail is not reported.
+    struct PassRun {
+        function<void(TACProgram&)> program;
+        function<void(CFG&)> perFunction;
+        function<string()> summary;
+        function<string()> detail;
+    };
+
+    struct PassInfo {
+        const char* name;
+        Form form;
+        function<PassRun(const EdgeProfile*)> create;
+    };
+
+    template <typename Pass, typename Run, typename Summary>
+    PassRun onProgram(Run run, Summary summary) {
+        auto pass = make_shared<Pass>();
+        return {[pass, run](TACProgram& program) { run(*pass, program); }, nullptr, [pass, summary] { return summary(*pass); }};
+    }
+
+    template <typename Pass, typename Summary>
+    PassRun onFunctions(Summary summary) {
+        auto pass = make_shared<Pass>();
+        return {nullptr, [pass](CFG& cfg) { pass->run(cfg); }, [pass, summary] { return summary(*pass); }};
+    }
+
+    string count(const string& what, int n) {
+        return what + ": " + to_string(n);
+    }
+
+    const vector<PassInfo> passes = {
+        {"tce", Form::Quads, [](const EdgeProfile*) {
+            return onProgram<TailCallEliminator>([](TailCallEliminator& p, TACProgram& program) { p.eliminateRecursion(program); },
+                                                 [](const TailCallEliminator& p) { return count("self tail calls turned into loops", p.getEliminatedCount()); });
+        }},
+        {"inline", Form::Quads, [](const EdgeProfile* profile) {
+            return onProgram<Inliner>([profile](Inliner& p, TACProgram& program) {
+                p.setProfile(profile);
+                p.run(program);
+            },
+                                      [](const Inliner& p) { return count("calls inlined", p.getInlinedCount()); });
+        }},
+        {"ipcp", Form::Quads, [](const EdgeProfile*) {
+            return onProgram<IPCP>([](IPCP& p, TACProgram& program) { p.run(program); }, [](const IPCP& p) {
+                return count("parameters bound", p.getPropagatedCount()) + ", " + count("specializations", p.getSpecializedCount()) +
+                       ", " + count("functions removed", p.getRemovedFunctionCount()) + ", " + count("globals removed", p.getRemovedGlobalCount());
+            });
+        }},
+        {"unroll", Form::Quads, [](const EdgeProfile* profile) {
+            return onProgram<LoopUnroller>([profile](LoopUnroller& p, TACProgram& program) {
+                p.setProfile(profile);
+                p.run(program);
+            }, [](const LoopUnroller& p) {
+                return count("fully unrolled", p.getFullyUnrolledCount()) + ", " + count("partially unrolled", p.getPartiallyUnrolledCount());
+            });
+        }},
+        {"tailcalls", Form::Quads, [](const EdgeProfile*) {
+            return onProgram<TailCallEliminator>([](TailCallEliminator& p, TACProgram& program) { p.markTailCalls(program); },
+                                                 [](const TailCallEliminator& p) { return count("tail calls marked", p.getMarkedCount()); });
+        }},
+        {"sccp", Form::SSA, [](const EdgeProfile*) {
+            return onFunctions<SCCP>([](const SCCP& p) {
+                return count("constants propagated", p.getPropagatedCount()) + ", " + count("branches removed", p.getRemovedBranchCount()) +
+                       ", " + count("blocks removed", p.getRemovedBlockCount());
+            });
+        }},
+        {"gvn", Form::SSA, [](const EdgeProfile*) {
+            // Also reported per function; the GVN's counter runs across all of them.
+            auto pass = make_shared<GVN>();
+            auto reported = make_shared<int>(0);
+            return PassRun{nullptr, [pass](CFG& cfg) { pass->run(cfg); },
+                           [pass] { return count("redundancies removed", pass->getRemovedCount()); },
+                           [pass, reported] {
+                               int removed = pass->getRemovedCount() - *reported;
+                               *reported = pass->getRemovedCount();
+                               return to_string(removed) + " redundancies removed";
+                           }};
+        }},
+        {"licm", Form::SSA, [](const EdgeProfile*) {
+            return onFunctions<LoopInvariantCodeMotion>([](const LoopInvariantCodeMotion& p) {
+                return count("loops", p.getLoopCount()) + ", " + count("quads hoisted", p.getHoistedCount());
+            });
+        }},
+        {"sr", Form::SSA, [](const EdgeProfile*) {
+            return onFunctions<StrengthReducer>([](const StrengthReducer& p) {
+                return count("induction variables", p.getInductionVariableCount()) + ", " + count("multiplications reduced", p.getReducedCount()) +
+                       ", " + count("tests replaced", p.getReplacedTestCount());
+            });
+        }},
+        {"dce", Form::SSA, [](const EdgeProfile*) {
+            return onFunctions<DeadCodeEliminator>([](const DeadCodeEliminator& p) {
+                return count("quads removed", p.getRemovedQuadCount()) + ", " + count("phis removed", p.getRemovedPhiCount()) +
+                       ", " + count("blocks removed", p.getRemovedBlockCount());
+            });
+        }},
+        {"simplify", Form::SSA, [](const EdgeProfile*) {
+            return onFunctions<CFGSimplifier>([](const CFGSimplifier& p) {
+                return count("jumps threaded", p.getThreadedCount()) + ", " + count("branches removed", p.getRemovedBranchCount()) +
+                       ", " + count("blocks merged", p.getMergedCount());
+            });
+        }},
+        {"compact", Form::CFG, [](const EdgeProfile*) {
+            // TempCompactor reports one function at a time.
+            auto temps = make_shared<pair<int, int>>();
+            auto copies = make_shared<int>(0);
+            return PassRun{nullptr,
+                           [temps, copies](CFG& cfg) {
+                               TempCompactor pass;
+                               pass.run(cfg);
+                               temps->first += pass.getTempsBefore();
+                               temps->second += pass.getTempsAfter();
+                               *copies += pass.getRemovedCopies();
+                           },
+                           [temps, copies] {
+                               return "temps: " + to_string(temps->first) + " -> " + to_string(temps->second) + ", " +
+                                      count("copies removed", *copies);
+                           }};
+        }},
+        {"layout", Form::Quads, [](const EdgeProfile* profile) {
+            auto pass = make_shared<BlockLayout>(profile);
+            return PassRun{[pass](TACProgram& program) { pass->run(program); }, nullptr, [pass] {
+                return count("functions laid out", pass->getLaidOutFunctionCount()) + ", " + count("blocks moved", pass->getMovedBlockCount());
+            }};
+        }},
+    };
+
+    const PassInfo* findPass(const string& name) {
+        for (const auto& pass : passes) {
+            if (name == pass.name) return &pass;
+        }
+        return nullptr;
+    }
+}
+
+vector<string> PassManager::pipelineFor(int level) {
+    switch (level) {
+        case 0: return {};
+        case 1: return {"tce", "sccp", "dce", "simplify", "compact", "tailcalls"};
+        case 2: return {"tce", "inline", "ipcp", "unroll", "sccp", "gvn", "licm", "sr", "dce", "simplify", "compact", "layout", "tailcalls"};
+        default: throw runtime_error("no optimization level " + to_string(level));
+    }
+}
+
+bool PassManager::hasPass(const string& name) {
+    return findPass(name) != nullptr;
+}
+
+void PassManager::setPipeline(const vector<string>& names) {
+    for (const auto& name : names) {
+        if (!hasPass(name)) throw runtime_error("unknown pass '" + name + "'");
+    }
+    pipeline = names;
+}
+
+void PassManager::run(TACProgram& program) {
+    struct FunctionState {
+        CFG cfg;
+        SSABuilder ssa;
+    };
+    vector<FunctionState> states; // parallel to program.functions while form != Quads
+    Form form = Form::Quads;
+    statistics.clear();
+
+    auto quadCount = [&] {
+        size_t n = 0;
+        if (form == Form::Quads) {
+            for (const auto& function : program.functions) n += function.quads.size();
+        } else {
+            for (const auto& state : states) {
+                for (const auto& block : state.cfg.blocks) n += block.quads.size() + block.phis.size();
+            }
+        }
+        return n;
+    };
+
+    auto verify = [&](const string& when) {
+        if (!verifying) return;
+        try {
+            if (form == Form::Quads) {
+                verifyProgram(program);
+                return;
+            }
+            for (size_t f = 0; f < states.size(); f++) {
+                try {
+                    verifyCFG(states[f].cfg, form == Form::SSA);
+                } catch (const runtime_error& e) {
+                    throw runtime_error("function " + program.functions[f].name.str() + ": " + e.what());
+                }
+            }
+        } catch (const runtime_error& e) {
+            throw runtime_error("invalid IR " + when + ": " + e.what());
+        }
+    };
+
+    auto step = [&](const string& name, const function<string()>& body) {
+        PassStatistics stats;
+        stats.name = name;
+        stats.quadsBefore = quadCount();
+        auto start = chrono::steady_clock::now();
+        stats.summary = body();
+        stats.milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        stats.quadsAfter = quadCount();
+        statistics.push_back(stats);
+        verify("after " + name);
+    };
+
+    // Converts every function to `target`, reusing whatever is cached.
+    auto reach = [&](Form target) {
+        if (form == target) return;
+        if (form == Form::SSA) {
+            step("ssa-destruct", [&] {
+                int splits = 0;
+                for (auto& state : states) {
+                    state.ssa.destruct(state.cfg);
+                    splits += state.ssa.getSplitEdgeCount();
+                }
+                form = Form::CFG;
+                return count("split edges", splits);
+            });
+        }
+        if (form == target) return;
+        if (target == Form::Quads) {
+            step("linearize", [&] {
+                for (size_t f = 0; f < states.size(); f++) program.functions[f].quads = states[f].cfg.linearize();
+                states.clear();
+                form = Form::Quads;
+                return string();
+            });
+            return;
+        }
+        if (form == Form::Quads) {
+            step("cfg-build", [&] {
+                for (const auto& function : program.functions) states.push_back({CFG::build(function.quads), SSABuilder()});
+                form = Form::CFG;
+                return count("functions", static_cast<int>(states.size()));
+            });
+        }
+        if (target == Form::SSA) {
+            step("ssa-construct", [&] {
+                int phis = 0;
+                for (auto& state : states) {
+                    state.ssa = SSABuilder();
+                    state.ssa.construct(state.cfg);
+                    phis += state.ssa.getPhiCount();
+                }
+                form = Form::SSA;
+                return count("phis", phis);
+            });
+        }
+    };
+
+    verify("before the first pass");
+    for (const auto& name : pipeline) {
+        const PassInfo& info = *findPass(name);
+        reach(info.form);
+        PassRun pass = info.create(profile);
+        vector<string> details;
+        step(name, [&] {
+            if (pass.program) {
+                pass.program(program);
+            } else {
+                for (size_t f = 0; f < states.size(); f++) {
+                    pass.perFunction(states[f].cfg);
+                    string detail = pass.detail ? pass.detail() : string();
+                    if (!detail.empty()) details.push_back(program.functions[f].name.str() + ": " + detail);
+                }
+            }
+            return pass.summary();
+        });
+        statistics.back().details = move(details);
+    }
+    reach(Form::Quads);
+}
+
+void PassManager::printStatistics(ostream& out) const {
+    auto flags = out.flags();
+    auto precision = out.precision();
+    double total = 0;
+    out << left << setw(14) << "pass" << right << setw(10) << "ms" << setw(10) << "before" << "    " << left << setw(10) << "after" << "effect\n";
+    out << fixed << setprecision(3);
+    for (const auto& stats : statistics) {
+        total += stats.milliseconds;
+        out << left << setw(14) << stats.name << right << setw(10) << stats.milliseconds
+            << setw(10) << stats.quadsBefore << " -> " << left << setw(10) << stats.quadsAfter << stats.summary << "\n";
+        for (const auto& detail : stats.details) out << "    " << detail << "\n";
+    }
+    out << left << setw(14) << "total" << right << setw(10) << total;
+    if (!statistics.empty()) out << setw(10) << statistics.front().quadsBefore << " -> " << statistics.back().quadsAfter;
+    out << "\n";
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,70 @@
+#ifndef PASS_MANAGER_HPP
+#define PASS_MANAGER_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "tac.hpp"
+
+using namespace std;
+
+class EdgeProfile;
+
+/**
+ * @brief What one step of a pipeline cost and did: wall-clock time, the
+ * program's quad count (phis included while in SSA form) before and
+ * after, and the pass's own counters, in total and, for passes that
+ * report them, per function ("<function>: <counters>").
+ */
+struct PassStatistics {
+    string name;
+    double milliseconds = 0;
+    size_t quadsBefore = 0;
+    size_t quadsAfter = 0;
+    string summary;
+    vector<string> details;
+};
+
+/**
+ * @brief Runs an ordered list of TAC passes over a program.
+ *
+ * Whole-program passes (tce, inline, ipcp, unroll, layout, tailcalls)
+ * work on the functions' quads. Per-function passes work on a CFG, in SSA
+ * form (sccp, gvn, licm, sr, dce, simplify) or out of it (compact). Each
+ * function's CFG, with the dominators and def-use chains it carries, is
+ * built once and kept across consecutive per-function passes; SSA is only
+ * destroyed when a pass needs it gone, and a whole-program pass
+ * invalidates the CFGs by writing them back to quads. Those conversions
+ * are timed as steps of their own.
+ *
+ * With verification on, the IR is checked before the first pass and after
+ * every step, and the error names the step that broke it. A loaded edge
+ * profile steers inline, unroll and layout; layout does nothing without.
+ */
+class PassManager {
+private:
+    vector<string> pipeline;
+    bool verifying = false;
+    const EdgeProfile* profile = nullptr;
+    vector<PassStatistics> statistics;
+
+public:
+    // The pipeline for -O0 (nothing), -O1 (cheap scalar cleanups) or -O2.
+    static vector<string> pipelineFor(int level);
+    static bool hasPass(const string& name);
+
+    explicit PassManager(int level = 2) : pipeline(pipelineFor(level)) {}
+
+    // Replaces the pipeline; throws runtime_error on an unknown pass.
+    void setPipeline(const vector<string>& names);
+    const vector<string>& getPipeline() const { return pipeline; }
+    void setVerifying(bool on) { verifying = on; }
+    void setProfile(const EdgeProfile* edgeProfile) { profile = edgeProfile; }
+
+    void run(TACProgram& program);
+
+    const vector<PassStatistics>& getStatistics() const { return statistics; }
+    void printStatistics(ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "profile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include "tac_io.hpp"
+
+namespace {
+    // FNV-1a over the program's binary form.
+    uint32_t checksumOf(const TACProgram& program) {
+        stringstream bytes;
+        writeTACBinary(bytes, program);
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : bytes.str()) {
+            hash ^= c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+}
+
+void EdgeProfile::number(TACProgram& program) {
+    int sites = 0;
+    functions.clear();
+    for (auto& function : program.functions) {
+        functions.push_back(function.name);
+        for (auto& quad : function.quads) {
+            if (quad.op == Op::IfFalse) quad.arg2 = Operand::intConst(sites++);
+        }
+    }
+    jumped.assign(sites, 0);
+    fellThrough.assign(sites, 0);
+    entries.assign(functions.size(), 0);
+    hottest = 0;
+    loaded = false;
+    checksum = checksumOf(program);
+}
+
+void EdgeProfile::load(istream& in) {
+    string magic;
+    int version = 0;
+    uint32_t sum = 0;
+    size_t branches = 0, functionCount = 0;
+    if (!(in >> magic >> version >> sum >> branches >> functionCount) || magic != "tacprof" || version != 1) {
+        throw runtime_error("not a profile");
+    }
+    if (sum != checksum || branches != jumped.size() || functionCount != functions.size()) {
+        throw runtime_error("profile was gathered from a different program");
+    }
+    for (size_t i = 0; i < branches; i++) {
+        if (!(in >> jumped[i] >> fellThrough[i])) throw runtime_error("truncated profile");
+        hottest = max(hottest, jumped[i] + fellThrough[i]);
+    }
+    for (size_t f = 0; f < functionCount; f++) {
+        if (!(in >> entries[f])) throw runtime_error("truncated profile");
+        hottest = max(hottest, entries[f]);
+    }
+    loaded = true;
+}
+
+int EdgeProfile::functionIndex(Name function) const {
+    auto it = find(functions.begin(), functions.end(), function);
+    if (it != functions.end()) return static_cast<int>(it - functions.begin());
+
+    const string& name = function.str();
+    size_t dot = name.rfind('.');
+    if (dot == string::npos || dot + 1 == name.size()) return -1;
+    for (size_t i = dot + 1; i < name.size(); i++) {
+        if (!isdigit(static_cast<unsigned char>(name[i]))) return -1;
+    }
+    return functionIndex(Name(name.substr(0, dot)));
+}
+
+int EdgeProfile::siteOf(const Quad& branch) const {
+    if (branch.op != Op::IfFalse || branch.arg2.kind() != OperandKind::Int) return -1;
+    int64_t site = branch.arg2.intValue();
+    return site >= 0 && site < static_cast<int64_t>(jumped.size()) ? static_cast<int>(site) : -1;
+}
+
+uint64_t EdgeProfile::edgeCount(const CFG& cfg, const vector<uint64_t>& counts, int from, int to) const {
+    const Quad* term = cfg.blocks[from].terminator();
+    int site = term ? siteOf(*term) : -1;
+    if (site < 0) return counts[from];
+    uint64_t count = 0;
+    if (cfg.blockForLabel(term->result) == to) count += jumped[site];
+    if (from + 1 == to) count += fellThrough[site];
+    return count;
+}
+
+vector<uint64_t> EdgeProfile::blockCounts(const CFG& cfg, Name function) const {
+    vector<uint64_t> counts(cfg.blocks.size(), 0);
+    if (!loaded) return counts;
+
+    // A numbered branch gives its block's count outright; the entry block
+    // runs once per call, and the rest add up their incoming edges. Edges
+    // from later blocks are still zero when their target is visited, which
+    // only matters on a cycle without a numbered branch.
+    vector<char> known(cfg.blocks.size(), 0);
+    for (const auto& block : cfg.blocks) {
+        const Quad* term = block.terminator();
+        int site = term ? siteOf(*term) : -1;
+        if (site < 0) continue;
+        counts[block.id] = jumped[site] + fellThrough[site];
+        known[block.id] = 1;
+    }
+    int f = functionIndex(function);
+    if (!cfg.blocks.empty() && !known[0] && f >= 0) {
+        counts[0] = entries[f];
+        known[0] = 1;
+    }
+    for (int b : cfg.reversePostorder()) {
+        if (known[b]) continue;
+        uint64_t count = 0;
+        for (int p : cfg.blocks[b].preds) count += edgeCount(cfg, counts, p, b);
+        counts[b] = count;
+    }
+    return counts;
+}
+
+vector<uint64_t> EdgeProfile::quadCounts(const TACFunction& function) const {
+    CFG cfg = CFG::build(function.quads);
+    vector<uint64_t> blocks = blockCounts(cfg, function.name);
+    vector<uint64_t> counts;
+    counts.reserve(function.quads.size());
+    for (const auto& block : cfg.blocks) {
+        if (!block.label.isNone()) counts.push_back(blocks[block.id]);
+        counts.insert(counts.end(), block.quads.size(), blocks[block.id]);
+    }
+    return counts;
+}
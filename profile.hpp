@@ -0,0 +1,67 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <iostream>
+#include <vector>
+#include "tac.hpp"
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Edge counts from a run of an instrumented build: how often each
+ * conditional branch jumped and fell through, and how often each function
+ * was entered.
+ *
+ * number() labels the front end's TAC before any pass runs: every
+ * if_false gets its site number in arg2, where passes carry it along, so
+ * the copies inlining and unrolling make share their original's counts.
+ * The instrumented build lowers each numbered branch with a counter on
+ * both edges (see QBEGenerator::setInstrumentation); a later build of the
+ * same program numbers it the same way and load()s the counts. Goto edges
+ * need no counter of their own: they run as often as their block.
+ *
+ * The file holds a header line `tacprof 1 <checksum> <branches>
+ * <functions>`, then the jumped and fell-through counts of each branch
+ * site and the entry count of each function, one number per line.
+ */
+class EdgeProfile {
+private:
+    uint32_t checksum = 0;
+    vector<Name> functions; // front end order
+    vector<uint64_t> jumped, fellThrough, entries;
+    uint64_t hottest = 0;
+    bool loaded = false;
+
+public:
+    // Numbers the branch sites of the front end's TAC.
+    void number(TACProgram& program);
+    // Reads counts written by an instrumented build of the numbered
+    // program; throws runtime_error if they belong to another one.
+    void load(istream& in);
+
+    bool isLoaded() const { return loaded; }
+    uint32_t getChecksum() const { return checksum; }
+    int getBranchCount() const { return static_cast<int>(jumped.size()); }
+    int getFunctionCount() const { return static_cast<int>(functions.size()); }
+    // The site number of a numbered if_false, or -1.
+    int siteOf(const Quad& branch) const;
+    // The entry counter of a function, or -1. IPCP's clone `f.2` counts as `f`.
+    int functionIndex(Name function) const;
+
+    // Whether the run says anything about the function.
+    bool covers(Name function) const { return loaded && functionIndex(function) >= 0; }
+    // Hot counts are within 1/16 of the program's busiest branch; cold
+    // ones never ran.
+    bool isHot(uint64_t count) const { return count > 0 && count * 16 >= hottest; }
+
+    // Estimated execution count of each block: that of its numbered
+    // branch, else the entry count or the sum of its incoming edges.
+    vector<uint64_t> blockCounts(const CFG& cfg, Name function) const;
+    // The same for each quad of a linear function (labels included).
+    vector<uint64_t> quadCounts(const TACFunction& function) const;
+    // How often control goes from block `from` to its successor `to`.
+    uint64_t edgeCount(const CFG& cfg, const vector<uint64_t>& counts, int from, int to) const;
+};
+
+#endif
@@ -16,94 +16,149 @@ string QBEGenerator::typeToQBE(TokenType type) {
     }
 }
 
-string QBEGenerator::formatName(const string& name) {
-    if (name == "true") return "1";
-    if (name == "false") return "0";
-    try {
-        size_t pos;
-        stod(name, &pos);
-        if (pos == name.length()) {
-            return name; 
-        }
-    } catch (...) {
-    }
-    
-    if (name.rfind("_t", 0) == 0) {
-        return "%" + name.substr(1); // e.g., _t0 -> %t0
+string QBEGenerator::formatOperand(Operand operand) {
+    switch (operand.kind()) {
+        case OperandKind::Bool:
+            return operand.boolValue() ? "1" : "0";
+        case OperandKind::Int:
+        case OperandKind::Float:
+            return operand.toString();
+        case OperandKind::Temp:
+            return "%t" + to_string(operand.payload()); // e.g., _t0 -> %t0
+        case OperandKind::Func:
+        case OperandKind::Global:
+            return "$" + operand.name().str();
+        case OperandKind::Label:
+            return "@L" + to_string(operand.payload()); // e.g., _L0 -> @L0
+        default:
+            return "%" + operand.toString();
     }
-    return "%" + name;
 }
 
 void QBEGenerator::emit(const string& line) {
     qbe_ir << line << endl;
 }
 
-void QBEGenerator::generateMainWrapper(const vector<Quad>& quads) {
-    emit("export function l $main() {"); 
-    emit("@start"); 
+/**
+ * @brief Emits one QBE function. `main` is exported; parameters arrive as
+ * %a0, %a1, ... and are picked up by the function's `param` quads.
+ */
+void QBEGenerator::generateFunction(const TACFunction& function) {
+    string params;
+    for (int i = 0; i < function.paramCount; i++) {
+        if (i) params += ", ";
+        params += "l %a" + to_string(i);
+    }
+    string linkage = function.name.str() == "main" ? "export " : "";
+    emit(linkage + "function l $" + function.name.str() + "(" + params + ") {");
+    emit("@start");
+    inMain = function.name.str() == "main";
+    if (sites) {
+        int entry = sites->functionIndex(function.name);
+        if (entry >= 0) emitIncrement(2 * sites->getBranchCount() + entry);
+    }
 
-    for (size_t i = 0; i < quads.size(); ++i) {
-        translateQuad(quads, i);
+    pendingArgs.clear();
+    for (size_t i = 0; i < function.quads.size(); ++i) {
+        translateQuad(function.quads, i);
     }
-    
-    emit("  ret 0"); 
     emit("}");
 }
+
 void QBEGenerator::translateQuad(const vector<Quad>& quads, size_t& index) {
     const Quad& quad = quads[index];
-    string resultName = formatName(quad.result);
-    string arg1Name = formatName(quad.arg1);
-    string arg2Name = formatName(quad.arg2);
-    
-    if (quad.op == "label") {
-        emit(quad.result + ":"); 
-        return;
-    }
+    string resultName = formatOperand(quad.result);
+    string arg1Name = formatOperand(quad.arg1);
+    string arg2Name = formatOperand(quad.arg2);
 
-    if (quad.op == "copy") {
-        emit("  " + resultName + " =l copy " + arg1Name);
-        return;
+    switch (quad.op) {
+        case Op::Label:
+            emit(resultName);
+            return;
+        case Op::Copy:
+            emit("  " + resultName + " =l copy " + arg1Name);
+            return;
+        case Op::Goto:
+            // e.g., jmp @L0
+            emit("  jmp " + resultName);
+            break;
+        case Op::IfFalse: {
+            // QBE branches name both targets; the true one is whatever
+            // follows, so reuse its label or open a fresh block.
+            bool labelled = index + 1 < quads.size() && quads[index + 1].op == Op::Label;
+            string trueLabel = labelled ? formatOperand(quads[index + 1].result) : "@f" + to_string(fallthroughCounter++);
+            int site = sites ? sites->siteOf(quad) : -1;
+            if (site < 0) {
+                emit("  jnz " + arg1Name + ", " + trueLabel + ", " + resultName);
+            } else {
+                // Each edge goes through a block that bumps its counter.
+                string edge = to_string(fallthroughCounter++);
+                emit("  jnz " + arg1Name + ", @pf" + edge + ", @pj" + edge);
+                emit("@pf" + edge);
+                emitIncrement(2 * site + 1);
+                emit("  jmp " + trueLabel);
+                emit("@pj" + edge);
+                emitIncrement(2 * site);
+                emit("  jmp " + resultName);
+            }
+            if (!labelled) emit(trueLabel);
+            return;
+        }
+        case Op::Neg:
+            emit("  " + resultName + " =l neg " + arg1Name);
+            return;
+        case Op::Not:
+            emit("  " + resultName + " =l ceql " + arg1Name + ", 0");
+            return;
+        case Op::Param:
+            emit("  " + resultName + " =l copy %a" + to_string(quad.arg1.intValue()));
+            return;
+        case Op::Arg:
+            pendingArgs.push_back("l " + arg1Name);
+            return;
+        case Op::Call:
+        case Op::TailCall: {
+            // QBE has no tail jump, so a tailcall stays a call and its ret.
+            string args;
+            for (size_t i = 0; i < pendingArgs.size(); i++) {
+                if (i) args += ", ";
+                args += pendingArgs[i];
+            }
+            pendingArgs.clear();
+            emit("  " + resultName + " =l call " + arg1Name + "(" + args + ")");
+            return;
+        }
+        case Op::Load:
+            emit("  " + resultName + " =l loadl " + arg1Name);
+            return;
+        case Op::Store:
+            emit("  storel " + arg1Name + ", " + resultName);
+            return;
+        case Op::Return:
+            if (sites && inMain) emit("  call $__tac_profile_dump()");
+            emit("  ret " + (quad.arg1.isNone() ? string("0") : arg1Name));
+            break;
+        default:
+            break;
     }
 
-    if (quad.op == "goto") {
-        // e.g., jmp _L0
-        emit("  jmp " + quad.result); 
+    // A jump ends the QBE block; anything after it needs a label of its own.
+    if (quad.op == Op::Goto || quad.op == Op::Return) {
+        if (index + 1 < quads.size() && quads[index + 1].op != Op::Label) {
+            emit("@f" + to_string(fallthroughCounter++));
+        }
         return;
     }
 
-    if (quad.op == "if_false") {
-        
-        string falseLabel = quad.result;
-        string trueLabel = "$L" + to_string(rand() % 1000000); 
-        string condReg = formatName(quad.arg1); 
-        emit("  jmpf " + condReg + ", " + falseLabel + ", " + trueLabel);
-        emit(trueLabel + ":");
-        return;
-    }
-    
-    map<string, string> opMap = {
-        {"+", "add"}, {"-", "sub"}, {"*", "mul"}, {"/", "div"},
-        {"==", "ceq"}, {"!=", "cne"}, {"<", "clt"}, {">", "cgt"}, {"<=", "cle"}, {">=", "cge"},
-        {"neg", "neg"}
+    static const map<Op, string> opMap = {
+        {Op::Add, "add"}, {Op::Sub, "sub"}, {Op::Mul, "mul"}, {Op::Div, "div"}, {Op::Mod, "rem"},
+        {Op::BitAnd, "and"}, {Op::BitOr, "or"}, {Op::BitXor, "xor"}, {Op::And, "and"}, {Op::Or, "or"},
+        {Op::Eq, "ceql"}, {Op::Ne, "cnel"}, {Op::Lt, "csltl"}, {Op::Gt, "csgtl"}, {Op::Le, "cslel"}, {Op::Ge, "csgel"}
     };
 
-    if (opMap.count(quad.op)) {
-        string qbeOp = opMap.at(quad.op);
-        
-        if (quad.op == "neg") { 
-            emit("  " + resultName + " =l neg " + arg1Name);
-        } else if (qbeOp.rfind("c", 0) == 0) {
-            string tempResult = "$b" + quad.result.substr(1); 
-            emit("  " + tempResult + " =b " + qbeOp + " " + arg1Name + ", " + arg2Name);
-            emit("  " + resultName + " =l extub " + tempResult); 
-        } else {
-            emit("  " + resultName + " =l " + qbeOp + " " + arg1Name + ", " + arg2Name);
-        }
-        return;
-    }
-
-    if (quad.op == "return") {
-        emit("  ret " + arg1Name);
+    auto it = opMap.find(quad.op);
+    if (it != opMap.end()) {
+        emit("  " + resultName + " =l " + it->second + " " + arg1Name + ", " + arg2Name);
         return;
     }
     emit("  # Unhandled quad: " + quad.toString());
@@ -111,14 +166,72 @@ void QBEGenerator::translateQuad(const vector<Quad>& quads, size_t& index) {
 
 
 
-string QBEGenerator::generate(const vector<Quad>& quads) {
+string QBEGenerator::generate(const TACProgram& program) {
     qbe_ir.str(""); 
     qbe_ir.clear();
-    generateMainWrapper(quads);
+    fallthroughCounter = 0;
+    counterTemps = 0;
+    for (Name global : program.globals) {
+        emit("data $" + global.str() + " = { l 0 }");
+    }
+    if (sites) emitProfileDump();
+    for (const auto& function : program.functions) {
+        generateFunction(function);
+    }
 
     return qbe_ir.str();
 }
 
 string QBEGenerator::newTemp() {
     return "_t" + to_string(argCounter++);
-}
\ No newline at end of file
+}
+
+void QBEGenerator::emitIncrement(int counter) {
+    string n = to_string(counterTemps++);
+    emit("  %pa" + n + " =l add $__tac_profile, " + to_string(8 * counter));
+    emit("  %pc" + n + " =l loadl %pa" + n);
+    emit("  %pc" + n + " =l add %pc" + n + ", 1");
+    emit("  storel %pc" + n + ", %pa" + n);
+}
+
+/**
+ * @brief Emits the counters and `$__tac_profile_dump`, which writes them
+ * in the format EdgeProfile::load reads.
+ */
+void QBEGenerator::emitProfileDump() {
+    string path;
+    for (char c : profilePath) {
+        if (c == '"' || c == '\\') path += '\\';
+        path += c;
+    }
+    int counters = 2 * sites->getBranchCount() + sites->getFunctionCount();
+    emit("data $__tac_profile = align 8 { z " + to_string(8 * max(counters, 1)) + " }");
+    emit("data $__tac_profile_path = { b \"" + path + "\", b 0 }");
+    emit("data $__tac_profile_mode = { b \"w\", b 0 }");
+    emit("data $__tac_profile_head = { b \"tacprof 1 %lu %lu %lu\\n\", b 0 }");
+    emit("data $__tac_profile_line = { b \"%lu\\n\", b 0 }");
+    emit("function $__tac_profile_dump() {");
+    emit("@start");
+    emit("  %file =l call $fopen(l $__tac_profile_path, l $__tac_profile_mode)");
+    emit("  %opened =w cnel %file, 0");
+    emit("  jnz %opened, @head, @done");
+    emit("@head");
+    emit("  call $fprintf(l %file, l $__tac_profile_head, ..., l " + to_string(sites->getChecksum()) + ", l " +
+         to_string(sites->getBranchCount()) + ", l " + to_string(sites->getFunctionCount()) + ")");
+    emit("  %i =l copy 0");
+    emit("@loop");
+    emit("  %more =w csltl %i, " + to_string(counters));
+    emit("  jnz %more, @body, @close");
+    emit("@body");
+    emit("  %offset =l mul %i, 8");
+    emit("  %at =l add $__tac_profile, %offset");
+    emit("  %count =l loadl %at");
+    emit("  call $fprintf(l %file, l $__tac_profile_line, ..., l %count)");
+    emit("  %i =l add %i, 1");
+    emit("  jmp @loop");
+    emit("@close");
+    emit("  call $fclose(l %file)");
+    emit("@done");
+    emit("  ret");
+    emit("}");
+}
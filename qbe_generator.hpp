@@ -6,6 +6,7 @@
 #include <vector>
 #include <sstream>
 #include "ir_generator.hpp" 
+#include "profile.hpp"
 #include "Utilities/token_types.hpp" 
 
 using namespace std;
@@ -14,16 +15,30 @@ class QBEGenerator {
 private:
     stringstream qbe_ir;
     int argCounter = 0;
+    int fallthroughCounter = 0; // labels for the fallthrough side of jnz
+    vector<string> pendingArgs; // `arg` quads waiting for their call
+    const EdgeProfile* sites = nullptr; // set when instrumenting
+    string profilePath;
+    int counterTemps = 0;
+    bool inMain = false;
     string newTemp();
     void translateQuad(const vector<Quad>& quads, size_t& index); 
-    string formatName(const string& name);
+    string formatOperand(Operand operand);
     string typeToQBE(TokenType type); 
     void emit(const string& line);
-    void generateMainWrapper(const vector<Quad>& quads);
+    void generateFunction(const TACFunction& function);
+    void emitIncrement(int counter);
+    void emitProfileDump();
     
 public:
     QBEGenerator() = default;
-    string generate(const vector<Quad>& quads);
+    // Counts both edges of every numbered if_false and each function's
+    // entries, and has main write the counts to `path` before it returns.
+    void setInstrumentation(const EdgeProfile* numbered, const string& path) {
+        sites = numbered;
+        profilePath = path;
+    }
+    string generate(const TACProgram& program);
 };
 
-#endif
\ No newline at end of file
+#endif
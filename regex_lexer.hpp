@@ -130,7 +130,7 @@ public:
             // Identifiers
             if (regex_search(begin, end, match, identifier) && match.position() == 0)
             {
-                tokens.push_back(Token(T_IDENTIFIER_RL, match.str(), startLine, startCol));
+                tokens.push_back(Token(T_IDENTIFIER_RL, Name(match.str()), startLine, startCol));
                 updatePosition(match.str());
                 begin = match[0].second;
                 continue;
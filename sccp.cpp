@@ -0,0 +1,230 @@
+#include "sccp.hpp"
+#include <algorithm>
+
+namespace {
+    bool isTruthy(Operand constant) {
+        switch (constant.kind()) {
+            case OperandKind::Bool: return constant.boolValue();
+            case OperandKind::Int: return constant.intValue() != 0;
+            default: return constant.floatValue() != 0.0;
+        }
+    }
+}
+
+SCCP::Lattice SCCP::valueOf(Operand operand) const {
+    Lattice value;
+    if (operand.isNone()) return value;
+    if (operand.isConstant()) {
+        value.level = Level::Constant;
+        value.value = operand;
+    } else if (operand.isTemp() && operand.payload() < values.size()) {
+        value = values[operand.payload()];
+    } else {
+        value.level = Level::Varying;
+    }
+    return value;
+}
+
+void SCCP::lower(Operand temp, const Lattice& value) {
+    if (!temp.isTemp()) return;
+    Lattice& current = values[temp.payload()];
+    if (value.level == Level::Undefined || current.level == Level::Varying) return;
+    if (current.level == Level::Constant && value.level == Level::Constant && current.value == value.value) return;
+    // Two different constants meet at Varying.
+    current.level = current.level == Level::Constant ? Level::Varying : value.level;
+    current.value = value.value;
+    ssaWork.push_back(temp.payload());
+}
+
+void SCCP::markEdge(const CFG& cfg, int from, int to) {
+    const auto& preds = cfg.blocks[to].preds;
+    size_t slot = find(preds.begin(), preds.end(), from) - preds.begin();
+    if (slot == preds.size() || liveEdges[to][slot]) return;
+    liveEdges[to][slot] = 1;
+    flowWork.push_back({from, to});
+}
+
+/**
+ * @brief Once the solver settles, an executable if_false whose condition is
+ * still Undefined has no live successor, and the values found so far assume
+ * the code after it never runs. Any value is a valid choice for an undefined
+ * condition, so take it as true: the branch falls through (or jumps, at the
+ * end of the function) and rewrite() folds it the same way.
+ */
+bool SCCP::resolveUndefinedBranch(const CFG& cfg) {
+    for (const auto& block : cfg.blocks) {
+        if (!executable[block.id] || block.quads.empty()) continue;
+        const Quad& last = block.quads.back();
+        if (last.op != Op::IfFalse || valueOf(last.arg1).level != Level::Undefined) continue;
+        size_t before = flowWork.size();
+        if (block.id + 1 < static_cast<int>(cfg.blocks.size())) {
+            markEdge(cfg, block.id, block.id + 1);
+        } else {
+            int target = cfg.blockForLabel(last.result);
+            if (target >= 0) markEdge(cfg, block.id, target);
+        }
+        if (flowWork.size() != before) return true;
+    }
+    return false;
+}
+
+void SCCP::visitPhi(int b, const Phi& phi) {
+    Lattice merged;
+    for (size_t i = 0; i < phi.args.size(); i++) {
+        if (!liveEdges[b][i]) continue;
+        Lattice arg = valueOf(phi.args[i]);
+        if (arg.level == Level::Undefined) continue;
+        if (arg.level == Level::Varying ||
+            (merged.level == Level::Constant && merged.value != arg.value)) {
+            merged.level = Level::Varying;
+            break;
+        }
+        merged = arg;
+    }
+    lower(phi.result, merged);
+}
+
+void SCCP::visitQuad(const CFG& cfg, int b, const Quad& quad) {
+    switch (quad.op) {
+        case Op::Label:
+        case Op::Return:
+            return;
+        case Op::Goto: {
+            int target = cfg.blockForLabel(quad.result);
+            if (target >= 0) markEdge(cfg, b, target);
+            return;
+        }
+        case Op::IfFalse: {
+            Lattice cond = valueOf(quad.arg1);
+            if (cond.level == Level::Undefined) return;
+            bool next = b + 1 < static_cast<int>(cfg.blocks.size());
+            bool taken = cond.level == Level::Varying || !isTruthy(cond.value);
+            bool skipped = cond.level == Level::Varying || isTruthy(cond.value);
+            int target = cfg.blockForLabel(quad.result);
+            if (taken && target >= 0) markEdge(cfg, b, target);
+            if (skipped && next) markEdge(cfg, b, b + 1);
+            return;
+        }
+        case Op::Call:
+        case Op::TailCall: {
+            Lattice varying;
+            varying.level = Level::Varying;
+            lower(quad.result, varying);
+            return;
+        }
+        default:
+            break;
+    }
+
+    Lattice result;
+    Lattice a = valueOf(quad.arg1);
+    Lattice c = isBinaryOp(quad.op) ? valueOf(quad.arg2) : a;
+    if (a.level == Level::Varying || c.level == Level::Varying) {
+        result.level = Level::Varying;
+    } else if (a.level == Level::Constant && c.level == Level::Constant) {
+        Operand folded;
+        if (evaluateOp(quad.op, a.value, c.value, folded)) {
+            result.level = Level::Constant;
+            result.value = folded;
+        } else {
+            result.level = Level::Varying;
+        }
+    }
+    lower(quad.result, result);
+}
+
+void SCCP::solve(CFG& cfg) {
+    const DefUseIndex& chains = cfg.defUse();
+    while (!flowWork.empty() || !ssaWork.empty()) {
+        while (!flowWork.empty()) {
+            int b = flowWork.back().second;
+            flowWork.pop_back();
+            const BasicBlock& block = cfg.blocks[b];
+            for (const auto& phi : block.phis) visitPhi(b, phi);
+            if (executable[b]) continue;
+            executable[b] = 1;
+            for (const auto& quad : block.quads) visitQuad(cfg, b, quad);
+            if (!block.terminator() && b + 1 < static_cast<int>(cfg.blocks.size())) markEdge(cfg, b, b + 1);
+        }
+        while (!ssaWork.empty()) {
+            uint32_t temp = ssaWork.back();
+            ssaWork.pop_back();
+            for (const Site& use : chains.usesOf(Operand::temp(temp))) {
+                if (!executable[use.block]) continue;
+                const BasicBlock& block = cfg.blocks[use.block];
+                if (use.isPhi()) visitPhi(use.block, block.phis[use.phi()]);
+                else visitQuad(cfg, use.block, block.quads[use.index]);
+            }
+        }
+    }
+}
+
+void SCCP::run(CFG& cfg) {
+    size_t blockCount = cfg.blocks.size();
+    values.assign(cfg.tempCount, Lattice());
+    executable.assign(blockCount, 0);
+    liveEdges.assign(blockCount, {});
+    flowWork.clear();
+    ssaWork.clear();
+
+    for (const auto& block : cfg.blocks) liveEdges[block.id].assign(block.preds.size(), 0);
+
+    flowWork.push_back({-1, 0});
+    do {
+        solve(cfg);
+    } while (resolveUndefinedBranch(cfg));
+
+    rewrite(cfg);
+}
+
+void SCCP::rewrite(CFG& cfg) {
+    auto constantFor = [&](Operand operand, Operand& out) {
+        if (!operand.isTemp() || operand.payload() >= values.size()) return false;
+        const Lattice& value = values[operand.payload()];
+        if (value.level != Level::Constant) return false;
+        out = value.value;
+        return true;
+    };
+    auto substitute = [&](Operand& operand) {
+        Operand constant;
+        if (constantFor(operand, constant)) operand = constant;
+    };
+
+    for (auto& block : cfg.blocks) {
+        Operand unused;
+        auto deadPhi = [&](const Phi& phi) { return constantFor(phi.result, unused); };
+        auto deadQuad = [&](const Quad& quad) {
+            return writesResult(quad.op) && !isCall(quad.op) && constantFor(quad.result, unused);
+        };
+        for (const auto& phi : block.phis) propagatedCount += deadPhi(phi);
+        for (const auto& quad : block.quads) propagatedCount += deadQuad(quad);
+        block.phis.erase(remove_if(block.phis.begin(), block.phis.end(), deadPhi), block.phis.end());
+        block.quads.erase(remove_if(block.quads.begin(), block.quads.end(), deadQuad), block.quads.end());
+
+        for (auto& phi : block.phis) {
+            for (auto& arg : phi.args) substitute(arg);
+        }
+        for (auto& quad : block.quads) {
+            substitute(quad.arg1);
+            substitute(quad.arg2);
+        }
+
+        if (!executable[block.id] || block.quads.empty()) continue;
+        Quad& last = block.quads.back();
+        if (last.op != Op::IfFalse) continue;
+        bool undefined = valueOf(last.arg1).level == Level::Undefined;
+        if (!last.arg1.isConstant() && !undefined) continue;
+        removedBranchCount++;
+        bool fallsThrough = block.id + 1 < static_cast<int>(cfg.blocks.size());
+        if (undefined ? fallsThrough : isTruthy(last.arg1)) {
+            block.quads.pop_back();
+        } else {
+            last = Quad(Op::Goto, Operand(), Operand(), last.result);
+        }
+    }
+
+    cfg.invalidateDefUse();
+    cfg.computeEdges();
+    cfg.computeDominators();
+    removedBlockCount += cfg.removeUnreachable();
+}
@@ -0,0 +1,51 @@
+#ifndef SCCP_HPP
+#define SCCP_HPP
+
+#include <vector>
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Sparse conditional constant propagation (Wegman & Zadeck) over a
+ * CFG in SSA form. Temps proven constant are replaced by their value, and
+ * if_false jumps on a known condition become a goto or are dropped, along
+ * with the blocks that can no longer run.
+ */
+class SCCP {
+private:
+    enum class Level : uint8_t { Undefined, Constant, Varying };
+
+    struct Lattice {
+        Level level = Level::Undefined;
+        Operand value;
+    };
+
+    vector<Lattice> values;          // indexed by temp number
+    vector<char> executable;         // per block
+    vector<vector<char>> liveEdges;  // liveEdges[b][i]: edge preds[i] -> b
+    vector<pair<int, int>> flowWork; // (from, to)
+    vector<uint32_t> ssaWork;        // temps whose lattice value dropped
+
+    int propagatedCount = 0;
+    int removedBranchCount = 0;
+    int removedBlockCount = 0;
+
+    Lattice valueOf(Operand operand) const;
+    void lower(Operand temp, const Lattice& value);
+    void markEdge(const CFG& cfg, int from, int to);
+    void visitPhi(int b, const Phi& phi);
+    void visitQuad(const CFG& cfg, int b, const Quad& quad);
+    void solve(CFG& cfg);
+    bool resolveUndefinedBranch(const CFG& cfg);
+    void rewrite(CFG& cfg);
+
+public:
+    void run(CFG& cfg);
+
+    int getPropagatedCount() const { return propagatedCount; }
+    int getRemovedBranchCount() const { return removedBranchCount; }
+    int getRemovedBlockCount() const { return removedBlockCount; }
+};
+
+#endif
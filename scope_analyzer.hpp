@@ -8,6 +8,7 @@
 #include <string>
 #include "Utilities/token_types.hpp"
 #include "ast.hpp"
+#include "Utilities/concurrent_symbol_table.hpp"
 
 using namespace std;
 
@@ -21,26 +22,34 @@ enum class ScopeError {
 
 // symbol representation
 struct Symbol {
-    string name;
+    Name name;
     TokenType type;
     bool isFunction;
     bool isDefined;
 
-    Symbol() : name(""), type(T_IDENTIFIER_RL), isFunction(false), isDefined(false) {}
+    Symbol() : type(T_IDENTIFIER_RL), isFunction(false), isDefined(false) {}
 
-    Symbol(string n, TokenType t, bool func = false, bool defined = true)
+    Symbol(Name n, TokenType t, bool func = false, bool defined = true)
         : name(n), type(t), isFunction(func), isDefined(defined) {}
 };
 
 // Scope (spaghetti scope representation)
+// The root scope keeps its symbols in a ConcurrentSymbolTable so functions can
+// be analyzed in parallel against it; nested scopes stay thread-local maps.
 class Scope {
 public:
-    unordered_map<string, Symbol> symbols;
+    unordered_map<Name, Symbol> symbols;
+    unique_ptr<ConcurrentSymbolTable<Symbol>> globals;
     shared_ptr<Scope> parent;
 
-    Scope(shared_ptr<Scope> p = nullptr) : parent(p) {}
+    Scope(shared_ptr<Scope> p = nullptr) : parent(p) {
+        if (!parent) globals.reset(new ConcurrentSymbolTable<Symbol>());
+    }
 
     bool addSymbol(const Symbol &sym) {
+        if (globals) {
+            return globals->insert(sym.name, sym);
+        }
         if (symbols.find(sym.name) != symbols.end()) {
             return false; 
         }
@@ -48,9 +57,13 @@ public:
         return true;
     }
 
-    Symbol *lookup(const string &name) {
-        if (symbols.find(name) != symbols.end())
-            return &symbols[name];
+    const Symbol *lookup(Name name) const {
+        if (globals) {
+            return globals->find(name);
+        }
+        auto it = symbols.find(name);
+        if (it != symbols.end())
+            return &it->second;
         if (parent)
             return parent->lookup(name);
         return nullptr;
@@ -60,6 +73,7 @@ public:
 class ScopeAnalyzer {
 private:
     shared_ptr<Scope> currentScope;
+    int errorCount = 0;
     
     void pushScope() {
         currentScope = make_shared<Scope>(currentScope);
@@ -69,7 +83,8 @@ private:
         if (currentScope) currentScope = currentScope->parent;
     }
 
-    void reportError(ScopeError err, const string &name) {
+    void reportError(ScopeError err, Name name) {
+        errorCount++;
         switch (err) {
         case ScopeError::UndeclaredVariableAccessed:
             cerr << "Scope Error: Undeclared variable accessed -> " << name << endl;
@@ -113,7 +128,7 @@ public:
         }
         case NODE_FUNC_CALL: {
             auto *fc = static_cast<FunctionCall *>(node);
-            Symbol *fn = currentScope->lookup(fc->name);
+            const Symbol *fn = currentScope->lookup(fc->name);
             if (!fn || !fn->isFunction) {
                 reportError(ScopeError::UndefinedFunctionCalled, fc->name);
             }
@@ -195,20 +210,8 @@ public:
 
         case NODE_FUNC_DECL: {
             auto *fd = static_cast<FunctionDecl *>(node);
-            Symbol sym(fd->name, fd->returnType, true);
-            if (!currentScope->addSymbol(sym)) {
-                reportError(ScopeError::FunctionPrototypeRedefinition, fd->name);
-            }
-
-            pushScope();
-            for (auto &p : fd->params) {
-                Symbol paramSym(p.name, p.type);
-                if (!currentScope->addSymbol(paramSym)) {
-                    reportError(ScopeError::VariableRedefinition, p.name);
-                }
-            }
-            analyze(fd->body);
-            popScope();
+            declareFunction(fd);
+            analyzeFunctionBody(fd);
             break;
         }
 
@@ -223,6 +226,36 @@ public:
         }
     }
 
+    // Adds the function's symbol to the current scope without visiting its body.
+    void declareFunction(FunctionDecl *fd) {
+        Symbol sym(fd->name, fd->returnType, true);
+        if (!currentScope->addSymbol(sym)) {
+            reportError(ScopeError::FunctionPrototypeRedefinition, fd->name);
+        }
+    }
+
+    void analyzeFunctionBody(FunctionDecl *fd) {
+        pushScope();
+        for (auto &p : fd->params) {
+            Symbol paramSym(p.name, p.type);
+            if (!currentScope->addSymbol(paramSym)) {
+                reportError(ScopeError::VariableRedefinition, p.name);
+            }
+        }
+        analyze(fd->body);
+        popScope();
+    }
+
+    // Adds a global variable's symbol without re-visiting its initializer.
+    void declareVariable(VarDecl *vd) {
+        Symbol sym(vd->ident, vd->type, false);
+        if (!currentScope->addSymbol(sym)) {
+            reportError(ScopeError::VariableRedefinition, vd->ident);
+        }
+    }
+
+    int getErrorCount() const { return errorCount; }
+
     shared_ptr<Scope> getGlobalScope() {
         auto s = currentScope;
         while (s->parent) {
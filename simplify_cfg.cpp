@@ -0,0 +1,185 @@
+#include "simplify_cfg.hpp"
+
+namespace {
+    bool isTruthy(Operand constant) {
+        switch (constant.kind()) {
+            case OperandKind::Bool: return constant.boolValue();
+            case OperandKind::Int: return constant.intValue() != 0;
+            default: return constant.floatValue() != 0.0;
+        }
+    }
+}
+
+void CFGSimplifier::run(CFG& cfg) {
+    bool changed = true;
+    while (changed) {
+        changed = threadJumps(cfg);
+        changed = threadKnownPhis(cfg) || changed;
+        changed = foldDominatedBranches(cfg) || changed;
+        changed = mergeBlocks(cfg) || changed;
+    }
+}
+
+bool CFGSimplifier::redirect(CFG& cfg, int from, int via, int to, Operand known, Operand value) {
+    BasicBlock& source = cfg.blocks[from];
+    const Quad* term = source.terminator();
+    bool jumps = term && term->op != Op::Return && !cfg.blocks[via].label.isNone() && term->result == cfg.blocks[via].label;
+    bool fallsInto = !term && from + 1 == via;
+    if (from == via || (!jumps && !fallsInto)) return false;
+
+    // A branch into a block with phis would need its edge split again to
+    // hold the copies, which is what `via` already is.
+    BasicBlock& target = cfg.blocks[to];
+    const auto& preds = target.preds;
+    if (!target.phis.empty() && (term && term->op == Op::IfFalse)) return false;
+    if (!target.phis.empty() && find(preds.begin(), preds.end(), from) != preds.end()) return false;
+
+    // Announce the new edge with its phi inputs so computeEdges keeps them.
+    size_t slot = find(preds.begin(), preds.end(), via) - preds.begin();
+    for (auto& phi : target.phis) {
+        Operand arg = phi.args[slot];
+        phi.args.push_back(!known.isNone() && arg == known ? value : arg);
+    }
+    target.preds.push_back(from);
+    if (!target.phis.empty()) cfg.invalidateBlock(to);
+
+    Operand label = cfg.labelOf(to);
+    if (jumps) source.quads.back().result = label;
+    else source.quads.push_back(Quad(Op::Goto, Operand(), Operand(), label));
+    cfg.computeEdges();
+    return true;
+}
+
+bool CFGSimplifier::threadJumps(CFG& cfg) {
+    bool changed = false;
+    for (size_t e = 1; e < cfg.blocks.size(); e++) {
+        const BasicBlock& block = cfg.blocks[e];
+        if (!block.phis.empty() || block.quads.size() > 1) continue;
+        int target;
+        if (block.quads.empty()) {
+            if (e + 1 >= cfg.blocks.size()) continue;
+            target = static_cast<int>(e + 1);
+        } else if (block.quads[0].op == Op::Goto) {
+            target = cfg.blockForLabel(block.quads[0].result);
+        } else {
+            continue;
+        }
+        if (target < 0 || target == static_cast<int>(e)) continue;
+
+        vector<int> preds = block.preds;
+        for (int p : preds) {
+            // Leave plain fallthrough into an empty block to mergeBlocks.
+            if (block.quads.empty() && p + 1 == static_cast<int>(e)) continue;
+            if (redirect(cfg, p, static_cast<int>(e), target)) {
+                threadedCount++;
+                changed = true;
+            }
+        }
+    }
+    if (changed) {
+        cfg.computeDominators();
+        cfg.removeUnreachable();
+    }
+    return changed;
+}
+
+bool CFGSimplifier::threadKnownPhis(CFG& cfg) {
+    bool changed = false;
+    for (size_t b = 1; b < cfg.blocks.size(); b++) {
+        const BasicBlock& block = cfg.blocks[b];
+        if (block.phis.size() != 1 || block.quads.size() != 1) continue;
+        const Quad& branch = block.quads[0];
+        Operand cond = block.phis[0].result;
+        if (branch.op != Op::IfFalse || branch.arg1 != cond || cfg.defUse().useCount(cond) != 1) continue;
+
+        for (size_t i = 0; i < block.preds.size(); i++) {
+            Operand arg = block.phis[0].args[i];
+            if (!arg.isConstant()) continue;
+            int target = isTruthy(arg) ? static_cast<int>(b + 1) : cfg.blockForLabel(branch.result);
+            if (target < 0 || target >= static_cast<int>(cfg.blocks.size()) || target == static_cast<int>(b)) continue;
+            if (redirect(cfg, block.preds[i], static_cast<int>(b), target, cond, arg)) {
+                threadedCount++;
+                removedBranchCount++;
+                changed = true;
+                break; // preds changed; the outer loop comes back
+            }
+        }
+    }
+    if (changed) {
+        cfg.computeDominators();
+        cfg.removeUnreachable();
+    }
+    return changed;
+}
+
+bool CFGSimplifier::foldDominatedBranches(CFG& cfg) {
+    bool changed = false;
+    for (auto& block : cfg.blocks) {
+        const Quad* term = block.terminator();
+        if (!term || term->op != Op::IfFalse || term->arg1.isConstant()) continue;
+
+        // Find the closest dominator branching on the same value and see
+        // which of its edges we are below.
+        int known = -1;
+        for (int child = block.id, d = block.idom; d >= 0; child = d, d = cfg.blocks[d].idom) {
+            const Quad* guard = cfg.blocks[d].terminator();
+            if (!guard || guard->op != Op::IfFalse || guard->arg1 != term->arg1) continue;
+            const BasicBlock& below = cfg.blocks[child];
+            int jumpTarget = cfg.blockForLabel(guard->result);
+            if (below.preds.size() == 1 && jumpTarget != d + 1) {
+                if (child == d + 1) known = 1;
+                else if (child == jumpTarget) known = 0;
+            }
+            break;
+        }
+        if (known < 0) continue;
+
+        if (known) block.quads.pop_back();
+        else block.quads.back() = Quad(Op::Goto, Operand(), Operand(), term->result);
+        cfg.invalidateBlock(block.id);
+        removedBranchCount++;
+        changed = true;
+    }
+    if (changed) {
+        cfg.computeEdges();
+        cfg.computeDominators();
+        cfg.removeUnreachable();
+    }
+    return changed;
+}
+
+bool CFGSimplifier::mergeBlocks(CFG& cfg) {
+    bool changed = false;
+    for (int a = 0; a < static_cast<int>(cfg.blocks.size()); a++) {
+        while (cfg.blocks[a].succs.size() == 1) {
+            int b = cfg.blocks[a].succs[0];
+            BasicBlock& first = cfg.blocks[a];
+            BasicBlock& second = cfg.blocks[b];
+            const Quad* term = first.terminator();
+            if (b == a || b == 0 || second.preds.size() != 1 || (term && term->op != Op::Goto)) break;
+
+            // Moving `second` up the layout must not change where it falls.
+            if (b != a + 1 && second.fallsThrough()) {
+                if (second.terminator() || b + 1 >= static_cast<int>(cfg.blocks.size())) break;
+                second.quads.push_back(Quad(Op::Goto, Operand(), Operand(), cfg.labelOf(b + 1)));
+            }
+
+            if (term) first.quads.pop_back();
+            for (const auto& phi : second.phis) first.quads.push_back(Quad(Op::Copy, phi.args[0], Operand(), phi.result));
+            first.quads.insert(first.quads.end(), second.quads.begin(), second.quads.end());
+            for (int s : second.succs) {
+                auto& preds = cfg.blocks[s].preds;
+                replace(preds.begin(), preds.end(), b, a);
+            }
+            second.quads.clear();
+            second.phis.clear();
+            cfg.removeBlock(b);
+            if (b < a) a--;
+            cfg.computeEdges();
+            mergedCount++;
+            changed = true;
+        }
+    }
+    if (changed) cfg.computeDominators();
+    return changed;
+}
@@ -0,0 +1,39 @@
+#ifndef SIMPLIFY_CFG_HPP
+#define SIMPLIFY_CFG_HPP
+
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Control-flow cleanup over a CFG in SSA form, repeated until
+ * nothing changes:
+ *  - jumps into blocks that only forward elsewhere go straight there;
+ *  - a block whose only predecessor flows into it alone is merged into it;
+ *  - an if_false whose outcome is fixed by a dominating if_false on the
+ *    same temp, or by the constant a predecessor feeds into it through a
+ *    phi, is replaced by the path actually taken.
+ */
+class CFGSimplifier {
+private:
+    int threadedCount = 0;
+    int mergedCount = 0;
+    int removedBranchCount = 0;
+
+    bool threadJumps(CFG& cfg);
+    bool threadKnownPhis(CFG& cfg);
+    bool foldDominatedBranches(CFG& cfg);
+    bool mergeBlocks(CFG& cfg);
+    // Makes `from` jump to `to` instead of `via`; phis in `to` take the
+    // value they would have received from `via`.
+    bool redirect(CFG& cfg, int from, int via, int to, Operand known = Operand(), Operand value = Operand());
+
+public:
+    void run(CFG& cfg);
+
+    int getThreadedCount() const { return threadedCount; }
+    int getMergedCount() const { return mergedCount; }
+    int getRemovedBranchCount() const { return removedBranchCount; }
+};
+
+#endif
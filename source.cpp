@@ -2,13 +2,21 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <filesystem>
+#include <thread>
+#include <chrono>
 #include "regex_lexer.hpp"
 #include "parser.hpp"
 #include "scope_analyzer.hpp"
 #include "Utilities/ast_printer.hpp"
 #include "type_checker.hpp"
+#include "incremental_analyzer.hpp"
+#include "constant_folder.hpp"
 #include "ir_generator.hpp" 
 #include "qbe_generator.hpp"
+#include "tac_io.hpp"
+#include "pass_manager.hpp"
+#include "profile.hpp"
 
 
 using namespace std;
@@ -125,7 +133,7 @@ string formatToken(const Token &token)
 
   if (token.type == T_IDENTIFIER_RL)
   {
-    return typeName + "(\"" + token.value + "\")";
+    return typeName + "(\"" + token.name.str() + "\")";
   }
   else if (token.type == T_INT_RLLIT)
   {
@@ -166,7 +174,15 @@ void printTokenStream(const vector<Token> &tokens)
   cout << "]" << endl;
 }
 
-int main()
+struct Options
+{
+  int level = 2;
+  bool verify = false, profileGenerate = false, profileUse = false, watch = false;
+};
+
+// Runs every stage on test.txt. The analyzer outlives a single call so that,
+// under -watch, only the units an edit affects are checked again.
+int compile(const Options &options, IncrementalAnalyzer &analyzer)
 {
   fstream file;
   string example1 = "";
@@ -210,30 +226,76 @@ int main()
     cout << "```\n"
          << endl;
 
-    // Scope Analysis
+    // Scope Analysis and Type Checker; the first update checks every unit.
     cout << "# Scope Analysis\n"
          << endl;
-    ScopeAnalyzer scopeAnalyzer;
-    for (auto stmt : ast)
+    cout << "# Type Checker\n";
+    analyzer.update(ast);
+    if (options.watch)
     {
-      scopeAnalyzer.analyze(stmt);
+      cout << "Re-checked:";
+      for (auto name : analyzer.getRechecked())
+        cout << " " << name;
+      cout << endl;
     }
-    
-    // Type Checker
-    cout << "# Type Checker\n";
-    TypeChecker typeChecker;
-    typeChecker.check(ast, scopeAnalyzer.getGlobalScope());
+
+    // Constant Folding
+    cout << "# Constant Folding\n";
+    ConstantFolder constantFolder;
+    constantFolder.fold(ast, analyzer.getTypeChecker());
+    cout << "Folded expressions: " << constantFolder.getFoldedCount()
+         << ", pruned branches: " << constantFolder.getPrunedCount()
+         << ", evaluated calls: " << constantFolder.getEvaluatedCallCount() << endl;
 
 
     cout << "# Intermediate Representation (TAC)\\n";
     IRGenerator irGenerator;
-    auto quads = irGenerator.generate(ast);
+    TACProgram program = irGenerator.generate(ast);
     irGenerator.printIRCode();
 
+    // Saved so tac_opt can redo the later stages without the front end.
+    ofstream tacFile("test.tac");
+    writeTACText(tacFile, program);
+    tacFile.close();
+
+    // Branches are numbered on the front end's TAC, which the instrumented
+    // build and the one using its profile have in common.
+    EdgeProfile profile;
+    if (options.profileGenerate || options.profileUse)
+      profile.number(program);
+    if (options.profileUse)
+    {
+      ifstream profileFile("test.prof");
+      try
+      {
+        if (!profileFile)
+          throw runtime_error("cannot open test.prof");
+        profile.load(profileFile);
+        cout << "Profile: " << profile.getBranchCount() << " branches, "
+             << profile.getFunctionCount() << " functions" << endl;
+      }
+      catch (const runtime_error &e)
+      {
+        cerr << "Warning: " << e.what() << "; optimizing without a profile" << endl;
+      }
+    }
+
+    cout << "# Optimization (-O" << options.level << ")\n";
+    PassManager passManager(options.level);
+    passManager.setVerifying(options.verify);
+    passManager.setProfile(&profile);
+    passManager.run(program);
+    passManager.printStatistics(cout);
+
+    cout << "# Optimized TAC\n";
+    writeTACText(cout, program);
+
     // --- QBE Generation (The New Backend) ---
     cout << "# QBE Backend Generation\\n";
     QBEGenerator qbeGenerator;
-    string qbeCode = qbeGenerator.generate(quads);
+    if (options.profileGenerate)
+      qbeGenerator.setInstrumentation(&profile, "test.prof");
+    string qbeCode = qbeGenerator.generate(program);
     
     cout << "--- Generated QBE IR ---\\n";
     cout << qbeCode;
@@ -244,7 +306,60 @@ int main()
   {
     std::cerr << "Parse error in Example 1: " << e.what() << endl;
   }
+  catch (const runtime_error &e)
+  {
+    std::cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
 
   
   return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char **argv)
+{
+  // -O0, -O1 or -O2 (the default) picks the optimization pipeline;
+  // -verify checks the IR after every pass. -profile-generate makes the
+  // QBE count branch edges into test.prof, which -profile-use reads back;
+  // it implies -O0 so that every branch is still there to be counted.
+  // -watch recompiles whenever test.txt is saved, until interrupted.
+  Options options;
+  for (int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if (arg == "-O0" || arg == "-O1" || arg == "-O2")
+      options.level = arg[2] - '0';
+    else if (arg == "-verify")
+      options.verify = true;
+    else if (arg == "-profile-generate")
+      options.profileGenerate = true;
+    else if (arg == "-profile-use")
+      options.profileUse = true;
+    else if (arg == "-watch")
+      options.watch = true;
+    else
+    {
+      cerr << "usage: " << argv[0] << " [-O0 | -O1 | -O2] [-verify] [-profile-generate | -profile-use] [-watch]" << endl;
+      return 2;
+    }
+  }
+  if (options.profileGenerate)
+    options.level = 0;
+
+  IncrementalAnalyzer analyzer;
+  int status = compile(options, analyzer);
+  if (!options.watch)
+    return status;
+
+  error_code ec;
+  auto stamp = filesystem::last_write_time("test.txt", ec);
+  while (true)
+  {
+    this_thread::sleep_for(chrono::milliseconds(500));
+    auto now = filesystem::last_write_time("test.txt", ec);
+    if (ec || now == stamp)
+      continue;
+    stamp = now;
+    compile(options, analyzer);
+  }
+}
@@ -0,0 +1,227 @@
+#include "ssa.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+void SSABuilder::construct(CFG& cfg) {
+    // Renaming walks the dominator tree, which only covers reachable code.
+    cfg.removeUnreachable();
+
+    // Temps written on several paths (e.g. the value of `a && b`) are
+    // renamed like variables.
+    sharedTemps.clear();
+    unordered_set<uint32_t> defined;
+    for (const auto& block : cfg.blocks) {
+        for (const auto& quad : block.quads) {
+            if (!writesResult(quad.op) || !quad.result.isTemp()) continue;
+            if (!defined.insert(quad.result.bits).second) sharedTemps.insert(quad.result.bits);
+        }
+    }
+
+    computeFrontiers(cfg);
+    insertPhis(cfg);
+    stacks.clear();
+    rename(cfg, 0);
+    cfg.invalidateDefUse();
+}
+
+void SSABuilder::computeFrontiers(const CFG& cfg) {
+    frontiers.assign(cfg.blocks.size(), {});
+    for (const auto& block : cfg.blocks) {
+        if (block.preds.size() < 2) continue;
+        for (int p : block.preds) {
+            for (int runner = p; runner != block.idom; runner = cfg.blocks[runner].idom) {
+                auto& df = frontiers[runner];
+                if (find(df.begin(), df.end(), block.id) == df.end()) df.push_back(block.id);
+            }
+        }
+    }
+}
+
+void SSABuilder::insertPhis(CFG& cfg) {
+    // Only variables read before being written in some block can need a phi.
+    unordered_set<uint32_t> global;
+    unordered_map<uint32_t, vector<int>> defSites;
+    vector<uint32_t> order; // first-definition order, so output is stable
+    for (const auto& block : cfg.blocks) {
+        unordered_set<uint32_t> killed;
+        for (const auto& quad : block.quads) {
+            for (Operand use : {quad.arg1, quad.arg2}) {
+                if (isVariable(use) && !killed.count(use.bits)) global.insert(use.bits);
+            }
+            if (writesResult(quad.op) && isVariable(quad.result)) {
+                killed.insert(quad.result.bits);
+                auto& sites = defSites[quad.result.bits];
+                if (sites.empty()) order.push_back(quad.result.bits);
+                if (sites.empty() || sites.back() != block.id) sites.push_back(block.id);
+            }
+        }
+    }
+
+    for (uint32_t var : order) {
+        if (!global.count(var)) continue;
+        vector<int> worklist = defSites[var];
+        vector<char> hasPhi(cfg.blocks.size(), 0);
+        vector<char> queued(cfg.blocks.size(), 0);
+        for (int b : worklist) queued[b] = 1;
+        while (!worklist.empty()) {
+            int b = worklist.back();
+            worklist.pop_back();
+            for (int d : frontiers[b]) {
+                if (hasPhi[d]) continue;
+                hasPhi[d] = 1;
+                Phi phi;
+                phi.var.bits = var;
+                phi.args.resize(cfg.blocks[d].preds.size());
+                cfg.blocks[d].phis.push_back(phi);
+                phiCount++;
+                if (!queued[d]) {
+                    queued[d] = 1;
+                    worklist.push_back(d);
+                }
+            }
+        }
+    }
+}
+
+bool SSABuilder::isVariable(Operand operand) const {
+    return operand.isVar() || (operand.isTemp() && sharedTemps.count(operand.bits));
+}
+
+Operand SSABuilder::currentDef(Operand var) const {
+    auto it = stacks.find(var.bits);
+    if (it == stacks.end() || it->second.empty()) return Operand();
+    return it->second.back();
+}
+
+Operand SSABuilder::define(CFG& cfg, Operand var) {
+    Operand name = cfg.newTemp();
+    stacks[var.bits].push_back(name);
+    return name;
+}
+
+void SSABuilder::rename(CFG& cfg, int b) {
+    vector<uint32_t> pushed;
+    BasicBlock& block = cfg.blocks[b];
+
+    for (auto& phi : block.phis) {
+        phi.result = define(cfg, phi.var);
+        pushed.push_back(phi.var.bits);
+    }
+    for (auto& quad : block.quads) {
+        for (Operand* use : {&quad.arg1, &quad.arg2}) {
+            if (!isVariable(*use)) continue;
+            // A read with no reaching definition keeps the variable itself.
+            Operand def = currentDef(*use);
+            if (!def.isNone()) *use = def;
+        }
+        if (writesResult(quad.op) && isVariable(quad.result)) {
+            pushed.push_back(quad.result.bits);
+            quad.result = define(cfg, quad.result);
+        }
+    }
+
+    for (int s : cfg.blocks[b].succs) {
+        auto& succ = cfg.blocks[s];
+        size_t slot = find(succ.preds.begin(), succ.preds.end(), b) - succ.preds.begin();
+        // Undefined incoming values stay empty; destruct() emits no copy for them.
+        for (auto& phi : succ.phis) phi.args[slot] = currentDef(phi.var);
+    }
+
+    for (int child : cfg.blocks[b].domChildren) rename(cfg, child);
+
+    for (uint32_t var : pushed) stacks[var].pop_back();
+}
+
+void SSABuilder::emitParallelCopy(CFG& cfg, vector<pair<Operand, Operand>> copies, vector<Quad>& out) {
+    // Emit a copy once nothing still pending reads its destination; when
+    // only cycles remain, save one destination in a temp to break it.
+    while (!copies.empty()) {
+        bool emitted = false;
+        for (size_t i = 0; i < copies.size(); i++) {
+            Operand dst = copies[i].first;
+            bool read = false;
+            for (size_t j = 0; j < copies.size() && !read; j++) {
+                read = j != i && copies[j].second == dst;
+            }
+            if (read) continue;
+            out.push_back(Quad(Op::Copy, copies[i].second, Operand(), dst));
+            copies.erase(copies.begin() + i);
+            emitted = true;
+            break;
+        }
+        if (emitted) continue;
+
+        Operand dst = copies.front().first;
+        Operand saved = cfg.newTemp();
+        out.push_back(Quad(Op::Copy, dst, Operand(), saved));
+        for (auto& copy : copies) {
+            if (copy.second == dst) copy.second = saved;
+        }
+    }
+}
+
+void SSABuilder::destruct(CFG& cfg) {
+    size_t original = cfg.blocks.size();
+    vector<vector<BasicBlock>> insertedAfter(original);
+    vector<BasicBlock> appended;
+
+    for (size_t b = 0; b < original; b++) {
+        if (cfg.blocks[b].phis.empty()) continue;
+        for (size_t i = 0; i < cfg.blocks[b].preds.size(); i++) {
+            vector<pair<Operand, Operand>> copies;
+            for (const auto& phi : cfg.blocks[b].phis) {
+                Operand arg = phi.args[i];
+                if (!arg.isNone() && arg != phi.result) copies.push_back({phi.result, arg});
+            }
+            if (copies.empty()) continue;
+
+            int p = cfg.blocks[b].preds[i];
+            BasicBlock& pred = cfg.blocks[p];
+            const Quad* term = pred.terminator();
+            vector<Quad> moves;
+            emitParallelCopy(cfg, copies, moves);
+
+            if (!term || term->op != Op::IfFalse) {
+                // The predecessor has a single successor: copy at its end.
+                auto at = term ? pred.quads.end() - 1 : pred.quads.end();
+                pred.quads.insert(at, moves.begin(), moves.end());
+                continue;
+            }
+
+            bool jumps = cfg.blockForLabel(term->result) == static_cast<int>(b);
+            bool fallsInto = p + 1 == static_cast<int>(b);
+            if (jumps && fallsInto) {
+                // Both edges reach b; the branch is pointless.
+                pred.quads.pop_back();
+                pred.quads.insert(pred.quads.end(), moves.begin(), moves.end());
+                continue;
+            }
+
+            BasicBlock split(-1);
+            split.quads = moves;
+            splitCount++;
+            if (jumps) {
+                split.label = cfg.newLabel();
+                split.quads.push_back(Quad(Op::Goto, Operand(), Operand(), cfg.blocks[b].label));
+                pred.quads.back().result = split.label;
+                appended.push_back(move(split));
+            } else {
+                insertedAfter[p].push_back(move(split));
+            }
+        }
+    }
+
+    vector<BasicBlock> blocks;
+    for (size_t b = 0; b < original; b++) {
+        cfg.blocks[b].phis.clear();
+        blocks.push_back(move(cfg.blocks[b]));
+        for (auto& split : insertedAfter[b]) blocks.push_back(move(split));
+    }
+    for (auto& split : appended) blocks.push_back(move(split));
+    for (size_t i = 0; i < blocks.size(); i++) blocks[i].id = static_cast<int>(i);
+
+    cfg.blocks = move(blocks);
+    cfg.invalidateDefUse();
+    cfg.computeEdges();
+    cfg.computeDominators();
+}
@@ -0,0 +1,44 @@
+#ifndef SSA_HPP
+#define SSA_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Converts a CFG to SSA form and back.
+ *
+ * construct() places phis on the iterated dominance frontier of each
+ * variable that is live across blocks (semi-pruned SSA) and renames every
+ * definition of a variable, or of a temp written more than once, to a
+ * fresh temp. destruct() turns phis back into copies on the incoming
+ * edges, splitting edges out of conditional jumps.
+ */
+class SSABuilder {
+private:
+    vector<vector<int>> frontiers;
+    unordered_map<uint32_t, vector<Operand>> stacks; // variable -> reaching definitions
+    unordered_set<uint32_t> sharedTemps;             // temps with more than one definition
+    int phiCount = 0;
+    int splitCount = 0;
+
+    void computeFrontiers(const CFG& cfg);
+    void insertPhis(CFG& cfg);
+    void rename(CFG& cfg, int block);
+    bool isVariable(Operand operand) const;
+    Operand currentDef(Operand var) const;
+    Operand define(CFG& cfg, Operand var);
+    void emitParallelCopy(CFG& cfg, vector<pair<Operand, Operand>> copies, vector<Quad>& out);
+
+public:
+    void construct(CFG& cfg);
+    void destruct(CFG& cfg);
+
+    int getPhiCount() const { return phiCount; }
+    int getSplitEdgeCount() const { return splitCount; }
+};
+
+#endif
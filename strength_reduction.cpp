@@ -0,0 +1,341 @@
+#include "strength_reduction.hpp"
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    // Ints are 64-bit and wrap, as in the generated code.
+    int64_t wrappedProduct(int64_t a, int64_t b) {
+        return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+    }
+
+    // a * b, or false if it does not fit in 64 bits.
+    bool exactProduct(int64_t a, int64_t b, int64_t& product) {
+        return !__builtin_mul_overflow(a, b, &product);
+    }
+
+    // Temps that hold the induction variable plus a constant, by offset.
+    using Offsets = unordered_map<uint32_t, int64_t>;
+
+    // Matches `result = v + c`, `result = c + v` or `result = v - c` for a
+    // v in `offsets`, giving result's offset.
+    bool matchStep(const Quad& quad, const Offsets& offsets, int64_t& offset) {
+        if (!quad.result.isTemp()) return false;
+        auto base = [&](Operand v) { return offsets.find(v.bits); };
+        if (quad.op == Op::Add && base(quad.arg1) != offsets.end() && quad.arg2.kind() == OperandKind::Int) {
+            offset = static_cast<int64_t>(static_cast<uint64_t>(base(quad.arg1)->second) + quad.arg2.intValue());
+        } else if (quad.op == Op::Add && base(quad.arg2) != offsets.end() && quad.arg1.kind() == OperandKind::Int) {
+            offset = static_cast<int64_t>(static_cast<uint64_t>(base(quad.arg2)->second) + quad.arg1.intValue());
+        } else if (quad.op == Op::Sub && base(quad.arg1) != offsets.end() && quad.arg2.kind() == OperandKind::Int) {
+            offset = static_cast<int64_t>(static_cast<uint64_t>(base(quad.arg1)->second) - quad.arg2.intValue());
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Matches `result = v * k` or `result = k * v` for a v in `offsets`.
+    bool matchScale(const Quad& quad, const Offsets& offsets, int64_t& factor, int64_t& offset) {
+        if (quad.op != Op::Mul || !quad.result.isTemp()) return false;
+        auto a = offsets.find(quad.arg1.bits), b = offsets.find(quad.arg2.bits);
+        if (a != offsets.end() && quad.arg2.kind() == OperandKind::Int) {
+            factor = quad.arg2.intValue();
+            offset = a->second;
+        } else if (b != offsets.end() && quad.arg1.kind() == OperandKind::Int) {
+            factor = quad.arg1.intValue();
+            offset = b->second;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // True if `value` is an int: TAC is untyped, so this follows its
+    // definitions through int arithmetic, copies and phis.
+    bool isIntValue(CFG& cfg, Operand value, unordered_set<uint32_t>& visiting) {
+        if (value.kind() == OperandKind::Int) return true;
+        if (!value.isTemp()) return false;
+        if (!visiting.insert(value.bits).second) return true; // a cycle adds nothing new
+        const auto& defs = cfg.defUse().definitionsOf(value);
+        if (defs.size() != 1) return false;
+        Site def = defs[0];
+        if (def.isPhi()) {
+            for (Operand arg : cfg.blocks[def.block].phis[def.phi()].args) {
+                if (!isIntValue(cfg, arg, visiting)) return false;
+            }
+            return true;
+        }
+        const Quad& quad = cfg.blocks[def.block].quads[def.index];
+        switch (quad.op) {
+            case Op::Copy:
+            case Op::Neg:
+                return isIntValue(cfg, quad.arg1, visiting);
+            case Op::Add:
+            case Op::Sub:
+            case Op::Mul:
+                return isIntValue(cfg, quad.arg1, visiting) && isIntValue(cfg, quad.arg2, visiting);
+            default:
+                return false;
+        }
+    }
+}
+
+void StrengthReducer::run(CFG& cfg) {
+    vector<Operand> headers;
+    for (const auto& loop : cfg.naturalLoops()) headers.push_back(cfg.blocks[loop.header].label);
+    for (Operand label : headers) {
+        int header = cfg.blockForLabel(label);
+        if (header >= 0) cfg.ensurePreheader(header);
+    }
+
+    for (const auto& loop : cfg.naturalLoops()) {
+        int preheader = cfg.ensurePreheader(loop.header);
+        if (preheader >= 0) reduceLoop(cfg, loop, preheader);
+    }
+}
+
+void StrengthReducer::reduceLoop(CFG& cfg, const Loop& loop, int preheader) {
+    const auto& preds = cfg.blocks[loop.header].preds;
+    size_t entry = find(preds.begin(), preds.end(), preheader) - preds.begin();
+    size_t phiCount = cfg.blocks[loop.header].phis.size();
+    vector<int> latches;
+    for (int p : preds) {
+        if (loop.contains(p)) latches.push_back(p);
+    }
+
+    vector<size_t> retired; // phis of ivs the test replacement left dead
+    for (size_t p = 0; p < phiCount; p++) {
+        Phi ivPhi = cfg.blocks[loop.header].phis[p];
+        Operand iv = ivPhi.result;
+        Operand init = ivPhi.args[entry];
+        unordered_set<uint32_t> visiting;
+        if (!isIntValue(cfg, init, visiting)) continue;
+
+        // Every back edge must carry the same `iv + c`.
+        Operand next;
+        bool single = true;
+        for (size_t i = 0; i < ivPhi.args.size(); i++) {
+            if (i == entry) continue;
+            if (!next.isNone() && ivPhi.args[i] != next) single = false;
+            next = ivPhi.args[i];
+        }
+        if (!single || !next.isTemp()) continue;
+
+        // The temps that are iv plus a constant, such as the `+ 1` chain an
+        // unrolled loop steps through; `next` must be one of them.
+        Offsets offsets{{iv.bits, 0}};
+        vector<Operand> members{iv};
+        int updateBlock = -1;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (int b : loop.blocks) {
+                for (const auto& quad : cfg.blocks[b].quads) {
+                    int64_t offset;
+                    if (offsets.count(quad.result.bits) || !matchStep(quad, offsets, offset)) continue;
+                    offsets[quad.result.bits] = offset;
+                    members.push_back(quad.result);
+                    if (quad.result == next) updateBlock = b;
+                    changed = true;
+                }
+            }
+        }
+        if (updateBlock < 0 || offsets[next.bits] == 0) continue;
+        int64_t step = offsets[next.bits];
+        inductionVariableCount++;
+
+        // Multiplications that run every iteration, by factor, with how
+        // many of them multiply iv itself.
+        map<int64_t, int> onIv;
+        unordered_set<uint32_t> products;
+        for (int b : loop.blocks) {
+            bool everyIteration = true;
+            for (int latch : latches) everyIteration = everyIteration && cfg.dominates(b, latch);
+            for (const auto& quad : cfg.blocks[b].quads) {
+                int64_t factor, offset;
+                if (!everyIteration || !matchScale(quad, offsets, factor, offset)) continue;
+                onIv[factor] += offset == 0;
+                products.insert(quad.result.bits);
+            }
+        }
+        if (onIv.empty()) continue;
+
+        // Linear function test replacement: `i < n` style tests become tests
+        // of the smallest positive multiple. It needs a constant start, and
+        // the bound check keeps products inside 64-bit range.
+        auto rescaledBound = [&](const Quad& quad, int64_t factor, int64_t& bound) {
+            if (!isComparison(quad.op) || quad.arg1 != iv || quad.arg2.kind() != OperandKind::Int) return false;
+            bool upward = step > 0 && (quad.op == Op::Lt || quad.op == Op::Le);
+            bool downward = step < 0 && (quad.op == Op::Gt || quad.op == Op::Ge);
+            if (!upward && !downward) return false;
+            int64_t reach = (step < 0 ? -step : step), low, high, scaledLow, scaledHigh;
+            bound = quad.arg2.intValue();
+            if (__builtin_sub_overflow(min(init.intValue(), bound), reach, &low) ||
+                __builtin_add_overflow(max(init.intValue(), bound), reach, &high) ||
+                !exactProduct(low, factor, scaledLow) || !exactProduct(high, factor, scaledHigh)) return false;
+            bound *= factor;
+            return true;
+        };
+
+        // It only pays if, once the products are reduced, iv and the temps
+        // stepped from it feed nothing in the loop but each other and that
+        // one test: then they all die, each with its add, and iv with its
+        // copy. Past the loop, iv is read back as the multiple divided by
+        // its factor, which the bound check keeps exact.
+        auto positive = onIv.upper_bound(0);
+        bool replaceTest = positive != onIv.end() && init.kind() == OperandKind::Int;
+        int tests = 0;
+        for (size_t m = 0; replaceTest && m < members.size(); m++) {
+            for (Site use : cfg.defUse().usesOf(members[m])) {
+                bool inside = loop.contains(use.block);
+                if (use.isPhi()) {
+                    if (use.block == loop.header && use.phi() == static_cast<int>(p)) continue;
+                    const auto& phi = cfg.blocks[use.block].phis[use.phi()];
+                    for (size_t a = 0; a < phi.args.size(); a++) {
+                        if (phi.args[a] == members[m] && (m != 0 || loop.contains(cfg.blocks[use.block].preds[a]))) replaceTest = false;
+                    }
+                    continue;
+                }
+                const Quad& quad = cfg.blocks[use.block].quads[use.index];
+                int64_t bound;
+                if (writesResult(quad.op) && (offsets.count(quad.result.bits) || products.count(quad.result.bits))) continue;
+                if (m == 0 && inside && rescaledBound(quad, positive->first, bound)) tests++;
+                else if (m != 0 || inside) replaceTest = false;
+            }
+        }
+        replaceTest = replaceTest && tests == 1;
+
+        // A new variable costs an add and, out of SSA, a copy every
+        // iteration. Products of iv + o only turn from multiplications into
+        // adds; each product of iv itself saves a quad, and the test
+        // replacement saves every member's.
+        int saved = 0;
+        for (const auto& group : onIv) saved += group.second;
+        replaceTest = replaceTest && saved + static_cast<int>(members.size()) > 2 * static_cast<int>(onIv.size());
+        if (!replaceTest) {
+            // Without it, only factors with enough products of iv pay.
+            for (auto it = onIv.begin(); it != onIv.end();) {
+                if (it->second > 2) it++;
+                else it = onIv.erase(it);
+            }
+            if (onIv.empty()) continue;
+        }
+
+        // One new variable per factor; a product of iv is replaced by it,
+        // one of iv + o becomes `var + o*k`.
+        map<int64_t, Operand> scaled;
+        vector<pair<Operand, Operand>> replaced; // product temp -> scaled variable
+        for (int b : loop.blocks) {
+            auto& quads = cfg.blocks[b].quads;
+            for (size_t i = 0; i < quads.size();) {
+                int64_t factor, offset;
+                if (!products.count(quads[i].result.bits) || !matchScale(quads[i], offsets, factor, offset) || !onIv.count(factor)) {
+                    i++;
+                    continue;
+                }
+                Operand& var = scaled[factor];
+                if (var.isNone()) var = cfg.newTemp();
+                if (offset == 0) {
+                    replaced.push_back({quads[i].result, var});
+                    quads.erase(quads.begin() + i);
+                } else {
+                    quads[i] = Quad(Op::Add, var, Operand::intConst(wrappedProduct(offset, factor)), quads[i].result);
+                    i++;
+                }
+                cfg.invalidateBlock(b);
+                reducedCount++;
+            }
+        }
+
+        for (const auto& entryPair : scaled) {
+            int64_t factor = entryPair.first;
+            Operand var = entryPair.second;
+            Operand varNext = cfg.newTemp();
+
+            // A constant start is folded; any other is scaled once, before the loop.
+            Operand start;
+            if (init.kind() == OperandKind::Int) {
+                start = Operand::intConst(wrappedProduct(init.intValue(), factor));
+            } else {
+                start = cfg.newTemp();
+                auto& target = cfg.blocks[preheader].quads;
+                auto at = cfg.blocks[preheader].terminator() ? target.end() - 1 : target.end();
+                target.insert(at, Quad(Op::Mul, init, Operand::intConst(factor), start));
+                cfg.invalidateBlock(preheader);
+            }
+
+            Phi phi;
+            phi.result = var;
+            phi.args.assign(ivPhi.args.size(), varNext);
+            phi.args[entry] = start;
+            cfg.blocks[loop.header].phis.push_back(phi);
+            cfg.invalidateBlock(loop.header);
+
+            auto& quads = cfg.blocks[updateBlock].quads;
+            for (size_t i = 0; i < quads.size(); i++) {
+                if (quads[i].result != next || !writesResult(quads[i].op)) continue;
+                Operand delta = Operand::intConst(wrappedProduct(step, factor));
+                quads.insert(quads.begin() + i + 1, Quad(Op::Add, var, delta, varNext));
+                cfg.invalidateBlock(updateBlock);
+                break;
+            }
+        }
+
+        for (const auto& r : replaced) cfg.defUse().replaceAllUses(cfg, r.first, r.second);
+
+        if (!replaceTest) continue;
+        Operand multiple = scaled[positive->first];
+        Operand factor = Operand::intConst(positive->first);
+        for (int b : loop.blocks) {
+            for (auto& quad : cfg.blocks[b].quads) {
+                int64_t bound;
+                if (!rescaledBound(quad, positive->first, bound)) continue;
+                quad.arg1 = multiple;
+                quad.arg2 = Operand::intConst(bound);
+                cfg.invalidateBlock(b);
+                replacedTestCount++;
+            }
+        }
+        for (int b = 0; b < static_cast<int>(cfg.blocks.size()); b++) {
+            if (loop.contains(b)) continue;
+            auto& quads = cfg.blocks[b].quads;
+            for (size_t i = 0; i < quads.size(); i++) {
+                if (quads[i].arg1 != iv && quads[i].arg2 != iv) continue;
+                Operand value = cfg.newTemp();
+                if (quads[i].arg1 == iv) quads[i].arg1 = value;
+                if (quads[i].arg2 == iv) quads[i].arg2 = value;
+                quads.insert(quads.begin() + i, Quad(Op::Div, multiple, factor, value));
+                i++;
+                cfg.invalidateBlock(b);
+            }
+            for (auto& phi : cfg.blocks[b].phis) {
+                for (size_t a = 0; a < phi.args.size(); a++) {
+                    if (phi.args[a] != iv) continue;
+                    int pred = cfg.blocks[b].preds[a];
+                    Operand value = cfg.newTemp();
+                    auto& target = cfg.blocks[pred].quads;
+                    auto at = cfg.blocks[pred].terminator() ? target.end() - 1 : target.end();
+                    target.insert(at, Quad(Op::Div, multiple, factor, value));
+                    phi.args[a] = value;
+                    cfg.invalidateBlock(pred);
+                    cfg.invalidateBlock(b);
+                }
+            }
+        }
+
+        // Nothing reads iv or its steps any more.
+        for (int b : loop.blocks) {
+            auto& quads = cfg.blocks[b].quads;
+            size_t before = quads.size();
+            quads.erase(remove_if(quads.begin(), quads.end(), [&](const Quad& quad) {
+                return writesResult(quad.op) && quad.result != iv && offsets.count(quad.result.bits);
+            }), quads.end());
+            if (quads.size() != before) cfg.invalidateBlock(b);
+        }
+        retired.push_back(p);
+    }
+
+    auto& phis = cfg.blocks[loop.header].phis;
+    for (auto it = retired.rbegin(); it != retired.rend(); ++it) phis.erase(phis.begin() + *it);
+    if (!retired.empty()) cfg.invalidateBlock(loop.header);
+}
@@ -0,0 +1,43 @@
+#ifndef STRENGTH_REDUCTION_HPP
+#define STRENGTH_REDUCTION_HPP
+
+#include <vector>
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Induction variable strength reduction over a CFG in SSA form.
+ *
+ * A basic induction variable is a header phi `i = phi(init, next)` with an
+ * integer start, where next is i plus a constant step reached through a
+ * chain of `+ c` temps (as unrolling leaves them). A product `i * k` or
+ * `(i + o) * k` with k an integer constant is replaced by a new variable
+ * stepped by step*k alongside i, with init*k computed in the preheader.
+ * Only products in blocks that dominate every latch are candidates, so a
+ * conditional multiply never turns into an unconditional add.
+ *
+ * The reduction has to pay for itself: each new variable costs an add and
+ * a copy per iteration, so a factor is reduced only when it removes more
+ * multiplies than that. When i is otherwise only compared against a
+ * constant bound, the test is rewritten on the new variable, uses of i
+ * after the loop read the multiple divided by k, and i and its chain are
+ * removed; those freed steps count toward the cost too.
+ */
+class StrengthReducer {
+private:
+    int inductionVariableCount = 0;
+    int reducedCount = 0;
+    int replacedTestCount = 0;
+
+    void reduceLoop(CFG& cfg, const Loop& loop, int preheader);
+
+public:
+    void run(CFG& cfg);
+
+    int getInductionVariableCount() const { return inductionVariableCount; }
+    int getReducedCount() const { return reducedCount; }
+    int getReplacedTestCount() const { return replacedTestCount; }
+};
+
+#endif
@@ -0,0 +1,375 @@
+#ifndef TAC_HPP
+#define TAC_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Utilities/symbol_interner.hpp"
+
+using namespace std;
+
+/**
+ * @brief Three-address code opcodes.
+ */
+enum class Op : uint8_t {
+    Copy,
+    Add, Sub, Mul, Div, Mod,
+    BitAnd, BitOr, BitXor,
+    And, Or,
+    Eq, Ne, Lt, Gt, Le, Ge,
+    Neg, Not,
+    Label, Goto, IfFalse,
+    Param, Arg, Call, TailCall, Return,
+    Load, Store
+};
+
+inline const char* opName(Op op) {
+    switch (op) {
+        case Op::Copy: return "copy";
+        case Op::Add: return "+";
+        case Op::Sub: return "-";
+        case Op::Mul: return "*";
+        case Op::Div: return "/";
+        case Op::Mod: return "%";
+        case Op::BitAnd: return "&";
+        case Op::BitOr: return "|";
+        case Op::BitXor: return "^";
+        case Op::And: return "&&";
+        case Op::Or: return "||";
+        case Op::Eq: return "==";
+        case Op::Ne: return "!=";
+        case Op::Lt: return "<";
+        case Op::Gt: return ">";
+        case Op::Le: return "<=";
+        case Op::Ge: return ">=";
+        case Op::Neg: return "neg";
+        case Op::Not: return "not";
+        case Op::Label: return "label";
+        case Op::Goto: return "goto";
+        case Op::IfFalse: return "if_false";
+        case Op::Param: return "param";
+        case Op::Arg: return "arg";
+        case Op::Call: return "call";
+        case Op::TailCall: return "tailcall";
+        case Op::Return: return "return";
+        case Op::Load: return "load";
+        case Op::Store: return "store";
+    }
+    return "?";
+}
+
+inline bool isBinaryOp(Op op) {
+    return op >= Op::Add && op <= Op::Ge;
+}
+
+inline bool isComparison(Op op) {
+    return op >= Op::Eq && op <= Op::Ge;
+}
+
+// True if the quad's `result` is a value it defines rather than a label
+// or a global it stores to.
+inline bool writesResult(Op op) {
+    return op != Op::Label && op != Op::Goto && op != Op::IfFalse && op != Op::Arg &&
+           op != Op::Return && op != Op::Store;
+}
+
+// A tailcall is a call whose result the next quad returns; backends that
+// can may turn it into a jump.
+inline bool isCall(Op op) {
+    return op == Op::Call || op == Op::TailCall;
+}
+
+// True if the quad reads or writes state other than its operands, so it
+// may not be merged with or moved past another such quad.
+inline bool touchesMemory(Op op) {
+    return isCall(op) || op == Op::Load || op == Op::Store;
+}
+
+/**
+ * @brief Process-wide pool of int and float constants referenced by operands.
+ */
+class ConstantPool {
+private:
+    vector<int64_t> ints;
+    vector<double> floats;
+    unordered_map<int64_t, uint32_t> intIndex;
+    unordered_map<uint64_t, uint32_t> floatIndex; // keyed by bit pattern
+
+public:
+    static ConstantPool& instance() {
+        static ConstantPool pool;
+        return pool;
+    }
+
+    uint32_t internInt(int64_t value) {
+        auto it = intIndex.find(value);
+        if (it != intIndex.end()) return it->second;
+        uint32_t index = static_cast<uint32_t>(ints.size());
+        ints.push_back(value);
+        intIndex.emplace(value, index);
+        return index;
+    }
+
+    uint32_t internFloat(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof bits);
+        auto it = floatIndex.find(bits);
+        if (it != floatIndex.end()) return it->second;
+        uint32_t index = static_cast<uint32_t>(floats.size());
+        floats.push_back(value);
+        floatIndex.emplace(bits, index);
+        return index;
+    }
+
+    int64_t intAt(uint32_t index) const { return ints[index]; }
+    double floatAt(uint32_t index) const { return floats[index]; }
+};
+
+enum class OperandKind : uint8_t {
+    None,
+    Temp,   // payload: temp number
+    Var,    // payload: interned variable name
+    Int,    // payload: ConstantPool int index
+    Float,  // payload: ConstantPool float index
+    Bool,   // payload: 0 or 1
+    Label,  // payload: label number
+    String, // payload: interned string literal
+    Func,   // payload: interned function name
+    Global  // payload: interned name of a top-level variable shared by functions
+};
+
+/**
+ * @brief A tagged 32-bit operand: 4-bit kind, 28-bit payload.
+ */
+struct Operand {
+    uint32_t bits;
+
+    static const uint32_t PAYLOAD_BITS = 28;
+    static const uint32_t PAYLOAD_MASK = (1u << PAYLOAD_BITS) - 1;
+
+    Operand() : bits(0) {}
+    // A payload that does not fit would alias a smaller one of the same kind.
+    Operand(OperandKind kind, uint32_t payload)
+        : bits((static_cast<uint32_t>(kind) << PAYLOAD_BITS) | payload) {
+        if (payload > PAYLOAD_MASK) {
+            throw runtime_error("operand payload " + to_string(payload) + " does not fit in " +
+                                to_string(PAYLOAD_BITS) + " bits");
+        }
+    }
+
+    static Operand none() { return Operand(); }
+    static Operand temp(uint32_t n) { return Operand(OperandKind::Temp, n); }
+    static Operand var(Name name) { return Operand(OperandKind::Var, name.id); }
+    static Operand intConst(int64_t v) { return Operand(OperandKind::Int, ConstantPool::instance().internInt(v)); }
+    static Operand floatConst(double v) { return Operand(OperandKind::Float, ConstantPool::instance().internFloat(v)); }
+    static Operand boolConst(bool v) { return Operand(OperandKind::Bool, v ? 1 : 0); }
+    static Operand label(uint32_t n) { return Operand(OperandKind::Label, n); }
+    static Operand str(Name value) { return Operand(OperandKind::String, value.id); }
+    static Operand func(Name name) { return Operand(OperandKind::Func, name.id); }
+    static Operand global(Name name) { return Operand(OperandKind::Global, name.id); }
+
+    OperandKind kind() const { return static_cast<OperandKind>(bits >> PAYLOAD_BITS); }
+    uint32_t payload() const { return bits & PAYLOAD_MASK; }
+
+    bool isNone() const { return kind() == OperandKind::None; }
+    bool isTemp() const { return kind() == OperandKind::Temp; }
+    bool isVar() const { return kind() == OperandKind::Var; }
+    bool isLabel() const { return kind() == OperandKind::Label; }
+    bool isConstant() const {
+        OperandKind k = kind();
+        return k == OperandKind::Int || k == OperandKind::Float || k == OperandKind::Bool;
+    }
+
+    Name name() const { return Name::fromId(payload()); }
+    int64_t intValue() const { return ConstantPool::instance().intAt(payload()); }
+    double floatValue() const { return ConstantPool::instance().floatAt(payload()); }
+    bool boolValue() const { return payload() != 0; }
+
+    bool operator==(const Operand& other) const { return bits == other.bits; }
+    bool operator!=(const Operand& other) const { return bits != other.bits; }
+
+    string toString() const {
+        switch (kind()) {
+            case OperandKind::None: return "";
+            case OperandKind::Temp: return "_t" + to_string(payload());
+            case OperandKind::Var: return name().str();
+            case OperandKind::Int: return to_string(intValue());
+            case OperandKind::Float: return to_string(floatValue());
+            case OperandKind::Bool: return boolValue() ? "true" : "false";
+            case OperandKind::Label: return "_L" + to_string(payload());
+            case OperandKind::String: return name().str();
+            case OperandKind::Func: return name().str();
+            case OperandKind::Global: return name().str();
+        }
+        return "";
+    }
+};
+
+namespace std {
+    template <>
+    struct hash<Operand> {
+        size_t operator()(const Operand& operand) const { return operand.bits; }
+    };
+}
+
+/**
+ * @brief Evaluates `op` on constant operands with the language's rules:
+ * 64-bit wrapping ints (the QBE backend computes them as `l`), int-to-float
+ * promotion, and no folding of division by zero. Returns false if the
+ * result must be left to run time.
+ */
+inline bool evaluateOp(Op op, Operand a, Operand b, Operand& out) {
+    OperandKind ka = a.kind(), kb = b.kind();
+    // Unsigned arithmetic wraps where signed overflow would be undefined.
+    auto wrap = [](uint64_t value) { return static_cast<int64_t>(value); };
+
+    if (op == Op::Copy) {
+        if (!a.isConstant()) return false;
+        out = a;
+        return true;
+    }
+    if (op == Op::Neg) {
+        if (ka == OperandKind::Int) out = Operand::intConst(wrap(0 - static_cast<uint64_t>(a.intValue())));
+        else if (ka == OperandKind::Float) out = Operand::floatConst(-a.floatValue());
+        else return false;
+        return true;
+    }
+    if (op == Op::Not) {
+        if (ka != OperandKind::Bool) return false;
+        out = Operand::boolConst(!a.boolValue());
+        return true;
+    }
+    if (!isBinaryOp(op) || !a.isConstant() || !b.isConstant()) return false;
+
+    if (ka == OperandKind::Bool && kb == OperandKind::Bool) {
+        bool l = a.boolValue(), r = b.boolValue();
+        switch (op) {
+            case Op::And: out = Operand::boolConst(l && r); return true;
+            case Op::Or: out = Operand::boolConst(l || r); return true;
+            case Op::Eq: out = Operand::boolConst(l == r); return true;
+            case Op::Ne: out = Operand::boolConst(l != r); return true;
+            default: return false;
+        }
+    }
+    if (ka == OperandKind::Bool || kb == OperandKind::Bool) return false;
+
+    if (ka == OperandKind::Int && kb == OperandKind::Int) {
+        int64_t l = a.intValue(), r = b.intValue();
+        switch (op) {
+            case Op::Add: out = Operand::intConst(wrap(static_cast<uint64_t>(l) + r)); return true;
+            case Op::Sub: out = Operand::intConst(wrap(static_cast<uint64_t>(l) - r)); return true;
+            case Op::Mul: out = Operand::intConst(wrap(static_cast<uint64_t>(l) * r)); return true;
+            case Op::Div:
+                if (r == 0 || (l == INT64_MIN && r == -1)) return false;
+                out = Operand::intConst(l / r); return true;
+            case Op::Mod:
+                if (r == 0 || (l == INT64_MIN && r == -1)) return false;
+                out = Operand::intConst(l % r); return true;
+            case Op::BitAnd: out = Operand::intConst(l & r); return true;
+            case Op::BitOr: out = Operand::intConst(l | r); return true;
+            case Op::BitXor: out = Operand::intConst(l ^ r); return true;
+            case Op::Eq: out = Operand::boolConst(l == r); return true;
+            case Op::Ne: out = Operand::boolConst(l != r); return true;
+            case Op::Lt: out = Operand::boolConst(l < r); return true;
+            case Op::Gt: out = Operand::boolConst(l > r); return true;
+            case Op::Le: out = Operand::boolConst(l <= r); return true;
+            case Op::Ge: out = Operand::boolConst(l >= r); return true;
+            default: return false;
+        }
+    }
+
+    double l = ka == OperandKind::Int ? a.intValue() : a.floatValue();
+    double r = kb == OperandKind::Int ? b.intValue() : b.floatValue();
+    switch (op) {
+        case Op::Add: out = Operand::floatConst(l + r); return true;
+        case Op::Sub: out = Operand::floatConst(l - r); return true;
+        case Op::Mul: out = Operand::floatConst(l * r); return true;
+        case Op::Div:
+            if (r == 0.0) return false;
+            out = Operand::floatConst(l / r); return true;
+        case Op::Eq: out = Operand::boolConst(l == r); return true;
+        case Op::Ne: out = Operand::boolConst(l != r); return true;
+        case Op::Lt: out = Operand::boolConst(l < r); return true;
+        case Op::Gt: out = Operand::boolConst(l > r); return true;
+        case Op::Le: out = Operand::boolConst(l <= r); return true;
+        case Op::Ge: out = Operand::boolConst(l >= r); return true;
+        default: return false;
+    }
+}
+
+/**
+ * @brief Represents a single Three-Address Code instruction (Quadruple).
+ * Jumps and labels keep their label in `result`, as does store its global.
+ * A call `r = call f, n` takes its n arguments from the `arg` quads that
+ * precede it, and `x = param i` binds a function's i-th parameter.
+ */
+struct Quad {
+    Op op;
+    Operand arg1;
+    Operand arg2;
+    Operand result;
+
+    Quad(Op o, Operand a1 = Operand(), Operand a2 = Operand(), Operand r = Operand())
+        : op(o), arg1(a1), arg2(a2), result(r) {}
+
+    string toString() const {
+        switch (op) {
+            case Op::Copy:
+                return result.toString() + " = " + arg1.toString();
+            case Op::Label:
+                return result.toString() + ":";
+            case Op::Goto:
+                return "goto " + result.toString();
+            case Op::IfFalse:
+                return "if_false " + arg1.toString() + " goto " + result.toString();
+            case Op::Neg:
+            case Op::Not:
+                return result.toString() + " = " + opName(op) + " " + arg1.toString();
+            case Op::Param:
+                return result.toString() + " = param " + arg1.toString();
+            case Op::Arg:
+                return "arg " + arg1.toString();
+            case Op::Call:
+            case Op::TailCall:
+                return result.toString() + " = " + opName(op) + " " + arg1.toString() + ", " + arg2.toString();
+            case Op::Return:
+                return "return " + arg1.toString();
+            case Op::Load:
+                return result.toString() + " = load " + arg1.toString();
+            case Op::Store:
+                return "store " + result.toString() + ", " + arg1.toString();
+            default:
+                return result.toString() + " = " + arg1.toString() + " " + opName(op) + " " + arg2.toString();
+        }
+    }
+};
+
+/**
+ * @brief TAC for one function. Top-level statements form `main`.
+ */
+struct TACFunction {
+    Name name;
+    int paramCount = 0;
+    vector<Quad> quads;
+};
+
+/**
+ * @brief A whole program: its functions and the top-level variables they
+ * share, which live in memory and are reached with load/store.
+ */
+struct TACProgram {
+    vector<TACFunction> functions;
+    vector<Name> globals;
+
+    TACFunction* find(Name name) {
+        for (auto& function : functions) {
+            if (function.name == name) return &function;
+        }
+        return nullptr;
+    }
+};
+
+#endif
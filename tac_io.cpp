@@ -0,0 +1,474 @@
+#include "tac_io.hpp"
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    const char BINARY_MAGIC[] = {'T', 'A', 'C', 'B'};
+    const uint8_t BINARY_VERSION = 1;
+
+    // ---- text ----
+
+    string quote(const string& text) {
+        string out = "\"";
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') out += string("\\") + static_cast<char>(c);
+            else if (c == '\n') out += "\\n";
+            else if (c == '\t') out += "\\t";
+            else if (c < 0x20 || c == 0x7f) {
+                char hex[8];
+                snprintf(hex, sizeof hex, "\\x%02x", c);
+                out += hex;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+        return out + "\"";
+    }
+
+    string spell(Operand operand) {
+        switch (operand.kind()) {
+            case OperandKind::None: return "";
+            case OperandKind::Temp: return "_t" + to_string(operand.payload());
+            case OperandKind::Label: return "_L" + to_string(operand.payload());
+            case OperandKind::Var: return "%" + operand.name().str();
+            case OperandKind::Global: return "@" + operand.name().str();
+            case OperandKind::Func: return "$" + operand.name().str();
+            case OperandKind::String: return quote(operand.name().str());
+            case OperandKind::Int: return to_string(operand.intValue());
+            case OperandKind::Bool: return operand.boolValue() ? "true" : "false";
+            case OperandKind::Float: {
+                char text[32];
+                snprintf(text, sizeof text, "%.17g", operand.floatValue());
+                string spelled = text;
+                if (spelled.find_first_of(".en") == string::npos) spelled += ".0";
+                return spelled;
+            }
+        }
+        return "";
+    }
+
+    string spell(const Quad& quad) {
+        switch (quad.op) {
+            case Op::Copy: return spell(quad.result) + " = " + spell(quad.arg1);
+            case Op::Label: return spell(quad.result) + ":";
+            case Op::Goto: return "goto " + spell(quad.result);
+            case Op::IfFalse: {
+                // A profile site number (see EdgeProfile) rides in arg2.
+                string text = "if_false " + spell(quad.arg1) + " goto " + spell(quad.result);
+                return quad.arg2.isNone() ? text : text + " branch " + spell(quad.arg2);
+            }
+            case Op::Neg:
+            case Op::Not: return spell(quad.result) + " = " + opName(quad.op) + " " + spell(quad.arg1);
+            case Op::Param: return spell(quad.result) + " = param " + spell(quad.arg1);
+            case Op::Arg: return "arg " + spell(quad.arg1);
+            case Op::Call:
+            case Op::TailCall:
+                return spell(quad.result) + " = " + opName(quad.op) + " " + spell(quad.arg1) + ", " + spell(quad.arg2);
+            case Op::Return: return quad.arg1.isNone() ? "return" : "return " + spell(quad.arg1);
+            case Op::Load: return spell(quad.result) + " = load " + spell(quad.arg1);
+            case Op::Store: return "store " + spell(quad.result) + ", " + spell(quad.arg1);
+            default:
+                return spell(quad.result) + " = " + spell(quad.arg1) + " " + opName(quad.op) + " " + spell(quad.arg2);
+        }
+    }
+
+    struct TextReader {
+        int line = 0;
+
+        [[noreturn]] void fail(const string& message) const {
+            throw runtime_error("tac:" + to_string(line) + ": " + message);
+        }
+
+        // Splits on blanks and commas; a quoted string is one token.
+        vector<string> tokenize(const string& text) const {
+            vector<string> tokens;
+            size_t i = 0;
+            while (i < text.size()) {
+                char c = text[i];
+                if (isspace(static_cast<unsigned char>(c)) || c == ',') {
+                    i++;
+                    continue;
+                }
+                size_t start = i;
+                if (c == '"') {
+                    for (i++; i < text.size() && text[i] != '"'; i++) {
+                        if (text[i] == '\\') i++;
+                    }
+                    if (i >= text.size()) fail("unterminated string");
+                    i++;
+                } else {
+                    while (i < text.size() && !isspace(static_cast<unsigned char>(text[i])) && text[i] != ',') i++;
+                }
+                tokens.push_back(text.substr(start, i - start));
+            }
+            return tokens;
+        }
+
+        string unquote(const string& token) const {
+            string out;
+            for (size_t i = 1; i + 1 < token.size(); i++) {
+                if (token[i] != '\\') {
+                    out += token[i];
+                    continue;
+                }
+                char c = token[++i];
+                if (c == 'n') out += '\n';
+                else if (c == 't') out += '\t';
+                else if (c == 'x' && i + 2 < token.size()) {
+                    out += static_cast<char>(strtol(token.substr(i + 1, 2).c_str(), nullptr, 16));
+                    i += 2;
+                } else {
+                    out += c;
+                }
+            }
+            return out;
+        }
+
+        bool isNumber(const string& token, size_t from) const {
+            if (from >= token.size()) return false;
+            for (size_t i = from; i < token.size(); i++) {
+                if (!isdigit(static_cast<unsigned char>(token[i]))) return false;
+            }
+            return true;
+        }
+
+        // The digits of token from `from` on, which must not exceed limit.
+        uint32_t count(const string& token, size_t from, uint32_t limit) const {
+            uint64_t value = 0;
+            for (size_t i = from; i < token.size(); i++) {
+                value = value * 10 + static_cast<uint64_t>(token[i] - '0');
+                if (value > limit) fail("'" + token + "' is out of range");
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        Operand operand(const string& token) const {
+            if (token.empty()) fail("missing operand");
+            string rest = token.substr(1);
+            switch (token[0]) {
+                case '"': return Operand::str(Name(unquote(token)));
+                case '%': return Operand::var(Name(rest));
+                case '@': return Operand::global(Name(rest));
+                case '$': return Operand::func(Name(rest));
+            }
+            if (token.compare(0, 2, "_t") == 0 && isNumber(token, 2))
+                return Operand::temp(count(token, 2, Operand::PAYLOAD_MASK));
+            if (token.compare(0, 2, "_L") == 0 && isNumber(token, 2))
+                return Operand::label(count(token, 2, Operand::PAYLOAD_MASK));
+            if (token == "true" || token == "false") return Operand::boolConst(token == "true");
+            if (isNumber(token, token[0] == '-' ? 1 : 0)) {
+                errno = 0;
+                long long value = strtoll(token.c_str(), nullptr, 10);
+                if (errno == ERANGE) fail("'" + token + "' is out of range");
+                return Operand::intConst(value);
+            }
+            char* end = nullptr;
+            double value = strtod(token.c_str(), &end);
+            if (end == token.c_str() || *end != '\0') fail("bad operand '" + token + "'");
+            return Operand::floatConst(value);
+        }
+
+        Operand operandOf(const string& token, OperandKind kind) const {
+            Operand parsed = operand(token);
+            if (parsed.kind() != kind) fail("unexpected operand '" + token + "'");
+            return parsed;
+        }
+
+        Op binaryOp(const string& token) const {
+            for (int op = static_cast<int>(Op::Add); op <= static_cast<int>(Op::Ge); op++) {
+                if (token == opName(static_cast<Op>(op))) return static_cast<Op>(op);
+            }
+            fail("unknown operator '" + token + "'");
+        }
+
+        Quad quad(const vector<string>& t) const {
+            size_t n = t.size();
+            if (n == 1 && t[0].size() > 1 && t[0].back() == ':')
+                return Quad(Op::Label, Operand(), Operand(), operandOf(t[0].substr(0, t[0].size() - 1), OperandKind::Label));
+            if (t[0] == "goto" && n == 2) return Quad(Op::Goto, Operand(), Operand(), operandOf(t[1], OperandKind::Label));
+            if (t[0] == "if_false" && (n == 4 || (n == 6 && t[4] == "branch")) && t[2] == "goto")
+                return Quad(Op::IfFalse, operand(t[1]), n == 6 ? operandOf(t[5], OperandKind::Int) : Operand(), operandOf(t[3], OperandKind::Label));
+            if (t[0] == "arg" && n == 2) return Quad(Op::Arg, operand(t[1]));
+            if (t[0] == "return" && n <= 2) return Quad(Op::Return, n == 2 ? operand(t[1]) : Operand());
+            if (t[0] == "store" && n == 3) return Quad(Op::Store, operand(t[2]), Operand(), operandOf(t[1], OperandKind::Global));
+            if (n < 3 || t[1] != "=") fail("unrecognized quad");
+
+            Operand result = operand(t[0]);
+            const string& word = t[2];
+            if (n == 3) return Quad(Op::Copy, operand(word), Operand(), result);
+            if (n == 4 && (word == "neg" || word == "not")) return Quad(word == "neg" ? Op::Neg : Op::Not, operand(t[3]), Operand(), result);
+            if (n == 4 && word == "param") return Quad(Op::Param, operandOf(t[3], OperandKind::Int), Operand(), result);
+            if (n == 4 && word == "load") return Quad(Op::Load, operandOf(t[3], OperandKind::Global), Operand(), result);
+            if (n == 5 && (word == "call" || word == "tailcall"))
+                return Quad(word == "call" ? Op::Call : Op::TailCall, operandOf(t[3], OperandKind::Func),
+                            operandOf(t[4], OperandKind::Int), result);
+            if (n == 5) return Quad(binaryOp(t[3]), operand(word), operand(t[4]), result);
+            fail("unrecognized quad");
+        }
+
+        TACProgram read(istream& in) {
+            TACProgram program;
+            string text;
+            bool versioned = false;
+            while (getline(in, text)) {
+                line++;
+                vector<string> t = tokenize(text);
+                if (t.empty() || t[0][0] == ';') continue;
+                if (!versioned) {
+                    if (t.size() != 2 || t[0] != "tac" || t[1] != "1") fail("expected 'tac 1'");
+                    versioned = true;
+                } else if (t[0] == "global" && t.size() == 2) {
+                    program.globals.push_back(operandOf(t[1], OperandKind::Global).name());
+                } else if (t[0] == "function" && t.size() == 2) {
+                    // $name(count):
+                    const string& header = t[1];
+                    size_t open = header.rfind('(');
+                    if (header[0] != '$' || open == string::npos || header.compare(header.size() - 2, 2, "):") != 0 ||
+                        !isNumber(header.substr(open + 1, header.size() - open - 3), 0))
+                        fail("bad function header");
+                    int paramCount = static_cast<int>(count(header.substr(open + 1, header.size() - open - 3), 0, INT_MAX));
+                    TACFunction function{Name(header.substr(1, open - 1)), paramCount, {}};
+                    program.functions.push_back(move(function));
+                } else {
+                    if (program.functions.empty()) fail("quad outside a function");
+                    program.functions.back().quads.push_back(quad(t));
+                }
+            }
+            if (!versioned) fail("empty input");
+            return program;
+        }
+    };
+
+    // ---- binary ----
+
+    struct BinaryWriter {
+        ostream& out;
+        unordered_map<uint32_t, uint32_t> nameIndex;
+        vector<Name> names;
+
+        explicit BinaryWriter(ostream& o) : out(o) {}
+
+        void byte(uint8_t value) { out.put(static_cast<char>(value)); }
+
+        void varint(uint64_t value) {
+            while (value >= 0x80) {
+                byte(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            byte(static_cast<uint8_t>(value));
+        }
+
+        void note(Name name) {
+            if (nameIndex.emplace(name.id, static_cast<uint32_t>(names.size())).second) names.push_back(name);
+        }
+
+        static bool isNamed(OperandKind kind) {
+            return kind == OperandKind::Var || kind == OperandKind::Global || kind == OperandKind::Func ||
+                   kind == OperandKind::String;
+        }
+
+        void payload(Operand operand) {
+            switch (operand.kind()) {
+                case OperandKind::None: return;
+                case OperandKind::Int: {
+                    int64_t value = operand.intValue();
+                    varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+                    return;
+                }
+                case OperandKind::Float: {
+                    double value = operand.floatValue();
+                    uint64_t bits;
+                    memcpy(&bits, &value, sizeof bits);
+                    for (int i = 0; i < 8; i++) byte(static_cast<uint8_t>(bits >> (8 * i)));
+                    return;
+                }
+                default:
+                    varint(isNamed(operand.kind()) ? nameIndex.at(operand.payload()) : operand.payload());
+            }
+        }
+
+        void write(const TACProgram& program) {
+            for (Name global : program.globals) note(global);
+            for (const auto& function : program.functions) {
+                note(function.name);
+                for (const auto& quad : function.quads) {
+                    for (Operand operand : {quad.arg1, quad.arg2, quad.result}) {
+                        if (isNamed(operand.kind())) note(operand.name());
+                    }
+                }
+            }
+
+            out.write(BINARY_MAGIC, sizeof BINARY_MAGIC);
+            byte(BINARY_VERSION);
+            varint(names.size());
+            for (Name name : names) {
+                varint(name.str().size());
+                out.write(name.str().data(), name.str().size());
+            }
+            varint(program.globals.size());
+            for (Name global : program.globals) varint(nameIndex.at(global.id));
+            varint(program.functions.size());
+            for (const auto& function : program.functions) {
+                varint(nameIndex.at(function.name.id));
+                varint(function.paramCount);
+                varint(function.quads.size());
+                for (const auto& quad : function.quads) {
+                    byte(static_cast<uint8_t>(quad.op));
+                    byte(static_cast<uint8_t>(static_cast<uint8_t>(quad.arg1.kind()) | static_cast<uint8_t>(quad.arg2.kind()) << 4));
+                    byte(static_cast<uint8_t>(quad.result.kind()));
+                    payload(quad.arg1);
+                    payload(quad.arg2);
+                    payload(quad.result);
+                }
+            }
+        }
+    };
+
+    struct BinaryReader {
+        istream& in;
+        vector<Name> names;
+
+        explicit BinaryReader(istream& i) : in(i) {}
+
+        [[noreturn]] static void fail(const string& message) {
+            throw runtime_error("tac binary: " + message);
+        }
+
+        uint8_t byte() {
+            int c = in.get();
+            if (c == EOF) fail("truncated input");
+            return static_cast<uint8_t>(c);
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t b = byte();
+                value |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) return value;
+            }
+            fail("bad varint");
+        }
+
+        // A temp or label number; larger ones do not fit an Operand.
+        uint32_t number() {
+            uint64_t value = varint();
+            if (value > Operand::PAYLOAD_MASK) fail("operand " + to_string(value) + " out of range");
+            return static_cast<uint32_t>(value);
+        }
+
+        // Bytes left in the input, or UINT64_MAX if the stream cannot tell.
+        uint64_t remaining() {
+            streampos here = in.tellg();
+            if (here < 0) return UINT64_MAX;
+            in.seekg(0, ios::end);
+            streampos end = in.tellg();
+            in.seekg(here);
+            return end < here ? 0 : static_cast<uint64_t>(end - here);
+        }
+
+        Name name() {
+            uint64_t index = varint();
+            if (index >= names.size()) fail("bad name index");
+            return names[index];
+        }
+
+        Operand operand(uint8_t kind) {
+            if (kind > static_cast<uint8_t>(OperandKind::Global)) fail("bad operand kind");
+            switch (static_cast<OperandKind>(kind)) {
+                case OperandKind::None: return Operand();
+                case OperandKind::Temp: return Operand::temp(number());
+                case OperandKind::Label: return Operand::label(number());
+                case OperandKind::Bool: return Operand::boolConst(varint() != 0);
+                case OperandKind::Var: return Operand::var(name());
+                case OperandKind::Global: return Operand::global(name());
+                case OperandKind::Func: return Operand::func(name());
+                case OperandKind::String: return Operand::str(name());
+                case OperandKind::Int: {
+                    uint64_t zigzag = varint();
+                    return Operand::intConst(static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+                }
+                case OperandKind::Float: {
+                    uint64_t bits = 0;
+                    for (int i = 0; i < 8; i++) bits |= static_cast<uint64_t>(byte()) << (8 * i);
+                    double value;
+                    memcpy(&value, &bits, sizeof value);
+                    return Operand::floatConst(value);
+                }
+            }
+            fail("bad operand kind");
+        }
+
+        TACProgram read() {
+            char magic[sizeof BINARY_MAGIC];
+            for (char& c : magic) c = static_cast<char>(byte());
+            if (memcmp(magic, BINARY_MAGIC, sizeof magic) != 0) fail("not a TAC binary");
+            if (byte() != BINARY_VERSION) fail("unsupported version");
+
+            for (uint64_t count = varint(); count > 0; count--) {
+                uint64_t length = varint();
+                if (length > remaining()) fail("name longer than the input");
+                string spelling;
+                for (; length > 0; length--) spelling += static_cast<char>(byte());
+                names.push_back(Name(spelling));
+            }
+            TACProgram program;
+            for (uint64_t count = varint(); count > 0; count--) program.globals.push_back(name());
+            for (uint64_t count = varint(); count > 0; count--) {
+                Name functionName = name();
+                uint64_t paramCount = varint();
+                if (paramCount > INT_MAX) fail("bad parameter count");
+                TACFunction function{functionName, static_cast<int>(paramCount), {}};
+                for (uint64_t quads = varint(); quads > 0; quads--) {
+                    uint8_t op = byte();
+                    if (op > static_cast<uint8_t>(Op::Store)) fail("bad op");
+                    uint8_t argKinds = byte();
+                    uint8_t resultKind = byte();
+                    Operand arg1 = operand(argKinds & 0xf);
+                    Operand arg2 = operand(argKinds >> 4);
+                    Operand result = operand(resultKind);
+                    function.quads.push_back(Quad(static_cast<Op>(op), arg1, arg2, result));
+                }
+                program.functions.push_back(move(function));
+            }
+            return program;
+        }
+    };
+}
+
+void writeTACText(ostream& out, const TACProgram& program) {
+    out << "tac 1" << endl;
+    for (Name global : program.globals) out << "global @" << global.str() << endl;
+    for (const auto& function : program.functions) {
+        out << "function $" << function.name.str() << "(" << function.paramCount << "):" << endl;
+        for (const auto& quad : function.quads) {
+            out << (quad.op == Op::Label ? "" : "  ") << spell(quad) << endl;
+        }
+    }
+}
+
+TACProgram readTACText(istream& in) {
+    return TextReader().read(in);
+}
+
+void writeTACBinary(ostream& out, const TACProgram& program) {
+    BinaryWriter(out).write(program);
+}
+
+TACProgram readTACBinary(istream& in) {
+    return BinaryReader(in).read();
+}
+
+TACProgram readTAC(istream& in) {
+    stringstream buffer;
+    buffer << in.rdbuf();
+    string data = buffer.str();
+    istringstream source(data);
+    if (data.compare(0, sizeof BINARY_MAGIC, BINARY_MAGIC, sizeof BINARY_MAGIC) == 0) return readTACBinary(source);
+    return readTACText(source);
+}
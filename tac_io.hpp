@@ -0,0 +1,38 @@
+#ifndef TAC_IO_HPP
+#define TAC_IO_HPP
+
+#include <iostream>
+#include "tac.hpp"
+
+using namespace std;
+
+/**
+ * @brief Reading and writing whole TAC programs, so stages after the front
+ * end can run in another process.
+ *
+ * The text form starts with `tac 1`, then one `global @g` line per global
+ * and, per function, a `function $f(n):` header followed by one quad per
+ * line, spelled as Quad::toString does, except that an if_false numbered
+ * for profiling ends in `branch <n>`. Operands carry their kind: `_t3`
+ * temps, `_L3` labels, `%x` variables, `@g` globals, `$f` functions,
+ * quoted strings with C escapes, ints, floats that always show a `.` or
+ * exponent, and `true`/`false`. Blank lines and lines starting with `;`
+ * are skipped.
+ *
+ * The binary form starts with the bytes `TACB` and a version byte. It
+ * holds a table of names, then the globals and functions. Each quad is
+ * its op, a byte of arg kinds, a result kind and LEB128 payloads.
+ *
+ * Readers throw runtime_error on malformed input, including numbers that
+ * do not fit their operand and lengths that run past the end of it.
+ */
+void writeTACText(ostream& out, const TACProgram& program);
+TACProgram readTACText(istream& in);
+
+void writeTACBinary(ostream& out, const TACProgram& program);
+TACProgram readTACBinary(istream& in);
+
+// Reads either form, telling them apart by the first bytes.
+TACProgram readTAC(istream& in);
+
+#endif
@@ -0,0 +1,145 @@
+// Loads TAC written by the front end (text or binary), runs optimization
+// passes over it and writes it back out, or lowers it to QBE.
+//
+//   g++ -std=c++17 -o tac_opt tac_opt.cpp tac_io.cpp qbe_generator.cpp
+//       cfg.cpp ssa.cpp sccp.cpp gvn.cpp dce.cpp licm.cpp strength_reduction.cpp
+//       simplify_cfg.cpp call_graph.cpp inliner.cpp tail_calls.cpp unroll.cpp ipcp.cpp
+//       temp_compaction.cpp def_use.cpp verifier.cpp pass_manager.cpp
+//       profile.cpp block_layout.cpp
+//   ./tac_opt [-O0 | -O1 | -O2 | -p pass,pass,...] [-stats] [-verify]
+//             [-profile-generate file | -profile-use file]
+//             [-S | -b | -qbe] [-o output] [input]
+//
+// -O picks one of the PassManager pipelines (none by default); -p runs the
+// listed passes instead, in the order given. -stats prints the time and
+// quad counts of every step to stderr, and -verify checks the IR after
+// each one. With -profile-generate, passes are skipped and -qbe output
+// counts branch edges into `file` when the program exits; -profile-use
+// reads such a file back to steer inlining, unrolling and block layout.
+// Both need the front end's TAC as input. Input defaults to stdin and
+// output to stdout; -S writes text (the default), -b binary.
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tac_io.hpp"
+#include "qbe_generator.hpp"
+#include "pass_manager.hpp"
+#include "profile.hpp"
+
+using namespace std;
+
+static vector<string> splitList(const string &list)
+{
+  vector<string> names;
+  stringstream in(list);
+  string name;
+  while (getline(in, name, ','))
+  {
+    if (!name.empty())
+      names.push_back(name);
+  }
+  return names;
+}
+
+int main(int argc, char **argv)
+{
+  int level = 0;
+  string pipeline;
+  bool stats = false, verify = false;
+  string format = "-S";
+  string inputPath, outputPath, profileOut, profileIn;
+  for (int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if (arg == "-O0" || arg == "-O1" || arg == "-O2")
+      level = arg[2] - '0';
+    else if (arg == "-p" && i + 1 < argc)
+      pipeline = argv[++i];
+    else if (arg == "-stats")
+      stats = true;
+    else if (arg == "-verify")
+      verify = true;
+    else if (arg == "-profile-generate" && i + 1 < argc)
+      profileOut = argv[++i];
+    else if (arg == "-profile-use" && i + 1 < argc)
+      profileIn = argv[++i];
+    else if (arg == "-o" && i + 1 < argc)
+      outputPath = argv[++i];
+    else if (arg == "-S" || arg == "-b" || arg == "-qbe")
+      format = arg;
+    else if (arg[0] != '-' && inputPath.empty())
+      inputPath = arg;
+    else
+    {
+      cerr << "usage: " << argv[0] << " [-O0 | -O1 | -O2 | -p pass,pass,...] [-stats] [-verify]"
+           << " [-profile-generate file | -profile-use file] [-S | -b | -qbe] [-o output] [input]" << endl;
+      return 2;
+    }
+  }
+
+  try
+  {
+    PassManager passManager(level);
+    passManager.setVerifying(verify);
+    if (!pipeline.empty())
+      passManager.setPipeline(splitList(pipeline));
+    // An optimized build would fold away branches before they are counted.
+    if (!profileOut.empty())
+      passManager.setPipeline({});
+
+    TACProgram program;
+    if (inputPath.empty())
+      program = readTAC(cin);
+    else
+    {
+      ifstream input(inputPath, ios::binary);
+      if (!input)
+        throw runtime_error("cannot open " + inputPath);
+      program = readTAC(input);
+    }
+
+    EdgeProfile profile;
+    if (!profileOut.empty() || !profileIn.empty())
+      profile.number(program);
+    if (!profileIn.empty())
+    {
+      ifstream input(profileIn);
+      if (!input)
+        throw runtime_error("cannot open " + profileIn);
+      profile.load(input);
+    }
+    passManager.setProfile(&profile);
+    passManager.run(program);
+    if (stats)
+      passManager.printStatistics(cerr);
+
+    ofstream file;
+    if (!outputPath.empty())
+    {
+      file.open(outputPath, ios::binary);
+      if (!file)
+        throw runtime_error("cannot write " + outputPath);
+    }
+    ostream &out = outputPath.empty() ? cout : file;
+    if (format == "-b")
+      writeTACBinary(out, program);
+    else if (format == "-qbe")
+    {
+      QBEGenerator generator;
+      if (!profileOut.empty())
+        generator.setInstrumentation(&profile, profileOut);
+      out << generator.generate(program);
+    }
+    else
+      writeTACText(out, program);
+  }
+  catch (const exception &e)
+  {
+    cerr << argv[0] << ": " << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include "tail_calls.hpp"
+#include <algorithm>
+
+namespace {
+    // The quad at `i` is a call whose result the next quad returns.
+    bool isTailCall(const vector<Quad>& quads, size_t i) {
+        return isCall(quads[i].op) && i + 1 < quads.size() && quads[i + 1].op == Op::Return &&
+               quads[i + 1].arg1 == quads[i].result;
+    }
+}
+
+void TailCallEliminator::eliminateRecursion(TACProgram& program) {
+    for (auto& function : program.functions) eliminateIn(function);
+}
+
+void TailCallEliminator::eliminateIn(TACFunction& function) {
+    auto& quads = function.quads;
+    Operand self = Operand::func(function.name);
+
+    // Parameters are bound by the leading param quads.
+    size_t bodyStart = 0;
+    vector<Operand> params(function.paramCount);
+    while (bodyStart < quads.size() && quads[bodyStart].op == Op::Param) {
+        size_t index = static_cast<size_t>(quads[bodyStart].arg1.intValue());
+        if (index < params.size()) params[index] = quads[bodyStart].result;
+        bodyStart++;
+    }
+    if (find(params.begin(), params.end(), Operand()) != params.end()) return;
+
+    uint32_t tempCount = 0, labelCount = 0;
+    for (const auto& quad : quads) {
+        for (Operand operand : {quad.arg1, quad.arg2, quad.result}) {
+            if (operand.isTemp()) tempCount = max(tempCount, operand.payload() + 1);
+            if (operand.isLabel()) labelCount = max(labelCount, operand.payload() + 1);
+        }
+    }
+    Operand top = Operand::label(labelCount);
+
+    vector<Quad> out(quads.begin(), quads.begin() + bodyStart);
+    out.push_back(Quad(Op::Label, Operand(), Operand(), top));
+    int before = eliminatedCount;
+    for (size_t i = bodyStart; i < quads.size(); i++) {
+        const Quad& quad = quads[i];
+        size_t argCount = params.size();
+        bool selfCall = quad.op == Op::Call && quad.arg1 == self && quad.arg2.intValue() == static_cast<int64_t>(argCount);
+        if (!selfCall || !isTailCall(quads, i) || out.size() < bodyStart + 1 + argCount) {
+            out.push_back(quad);
+            continue;
+        }
+        vector<Operand> args(argCount);
+        bool passed = true;
+        for (size_t a = 0; a < argCount; a++) {
+            const Quad& arg = out[out.size() - argCount + a];
+            passed = passed && arg.op == Op::Arg;
+            args[a] = arg.arg1;
+        }
+        if (!passed) {
+            out.push_back(quad);
+            continue;
+        }
+        out.erase(out.end() - argCount, out.end());
+
+        // Arguments that read a parameter are saved first, since the
+        // parameters are about to be overwritten.
+        for (auto& arg : args) {
+            if (find(params.begin(), params.end(), arg) == params.end()) continue;
+            Operand saved = Operand::temp(tempCount++);
+            out.push_back(Quad(Op::Copy, arg, Operand(), saved));
+            arg = saved;
+        }
+        for (size_t a = 0; a < argCount; a++) {
+            out.push_back(Quad(Op::Copy, args[a], Operand(), params[a]));
+        }
+        out.push_back(Quad(Op::Goto, Operand(), Operand(), top));
+        i++; // the return
+        eliminatedCount++;
+    }
+    if (eliminatedCount != before) quads = move(out);
+}
+
+void TailCallEliminator::markTailCalls(TACProgram& program) {
+    for (auto& function : program.functions) {
+        auto& quads = function.quads;
+        for (size_t i = 0; i < quads.size(); i++) {
+            if (quads[i].op != Op::Call || !isTailCall(quads, i)) continue;
+            quads[i].op = Op::TailCall;
+            markedCount++;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef TAIL_CALLS_HPP
+#define TAIL_CALLS_HPP
+
+#include "tac.hpp"
+
+using namespace std;
+
+/**
+ * @brief Tail-call handling on a program's TAC.
+ *
+ * eliminateRecursion() runs before SSA and turns every `r = call f, n`
+ * inside f that is directly followed by `return r` into copies of the
+ * arguments into f's parameters and a jump back to just after the `param`
+ * quads, so tail-recursive functions run as loops in constant stack space.
+ * markTailCalls() runs on the final TAC and turns the remaining call/return
+ * pairs into tailcall, for backends that can emit them as jumps.
+ */
+class TailCallEliminator {
+private:
+    int eliminatedCount = 0;
+    int markedCount = 0;
+
+    void eliminateIn(TACFunction& function);
+
+public:
+    void eliminateRecursion(TACProgram& program);
+    void markTailCalls(TACProgram& program);
+
+    int getEliminatedCount() const { return eliminatedCount; }
+    int getMarkedCount() const { return markedCount; }
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "temp_compaction.hpp"
+#include <algorithm>
+#include <climits>
+#include <queue>
+
+namespace {
+    struct BitSet {
+        vector<uint64_t> words;
+
+        explicit BitSet(size_t bits = 0) : words((bits + 63) / 64, 0) {}
+
+        void set(size_t bit) { words[bit / 64] |= uint64_t(1) << (bit % 64); }
+        void reset(size_t bit) { words[bit / 64] &= ~(uint64_t(1) << (bit % 64)); }
+        bool test(size_t bit) const { return words[bit / 64] >> (bit % 64) & 1; }
+
+        template <typename Visit>
+        void forEach(Visit visit) const {
+            for (size_t w = 0; w < words.size(); w++) {
+                for (uint64_t word = words[w]; word; word &= word - 1) visit(w * 64 + __builtin_ctzll(word));
+            }
+        }
+    };
+
+    struct Interval {
+        int start = INT_MAX;
+        int end = -1;
+
+        void cover(int position) {
+            start = min(start, position);
+            end = max(end, position);
+        }
+    };
+
+    // Temps a quad reads and the one it writes, if any.
+    template <typename Visit>
+    void forEachUse(const Quad& quad, Visit visit) {
+        if (quad.arg1.isTemp()) visit(quad.arg1);
+        if (quad.arg2.isTemp()) visit(quad.arg2);
+        if (!writesResult(quad.op) && quad.result.isTemp()) visit(quad.result);
+    }
+
+    bool definesTemp(const Quad& quad) {
+        return writesResult(quad.op) && quad.result.isTemp();
+    }
+}
+
+void TempCompactor::run(CFG& cfg) {
+    // Dense numbers for the temps in use.
+    uint32_t limit = 0;
+    for (const auto& block : cfg.blocks) {
+        for (const auto& quad : block.quads) {
+            for (Operand operand : {quad.arg1, quad.arg2, quad.result}) {
+                if (operand.isTemp()) limit = max(limit, operand.payload() + 1);
+            }
+        }
+    }
+    vector<int> dense(limit, -1);
+    vector<uint32_t> original;
+    for (const auto& block : cfg.blocks) {
+        for (const auto& quad : block.quads) {
+            for (Operand operand : {quad.arg1, quad.arg2, quad.result}) {
+                if (!operand.isTemp() || dense[operand.payload()] >= 0) continue;
+                dense[operand.payload()] = static_cast<int>(original.size());
+                original.push_back(operand.payload());
+            }
+        }
+    }
+    tempsBefore = static_cast<int>(original.size());
+    if (original.empty()) return;
+
+    // Only temps read before any write in some block can be live across
+    // blocks; they alone get bits.
+    const size_t blockCount = cfg.blocks.size();
+    vector<int> global(original.size(), -1);
+    size_t globalCount = 0;
+    vector<int> writtenIn(original.size(), -1);
+    for (size_t b = 0; b < blockCount; b++) {
+        for (const auto& quad : cfg.blocks[b].quads) {
+            forEachUse(quad, [&](Operand temp) {
+                int t = dense[temp.payload()];
+                if (writtenIn[t] != static_cast<int>(b) && global[t] < 0) global[t] = static_cast<int>(globalCount++);
+            });
+            if (definesTemp(quad)) writtenIn[dense[quad.result.payload()]] = static_cast<int>(b);
+        }
+    }
+
+    vector<BitSet> uses(blockCount, BitSet(globalCount)), defs(blockCount, BitSet(globalCount));
+    vector<BitSet> liveIn(blockCount, BitSet(globalCount)), liveOut(blockCount, BitSet(globalCount));
+    for (size_t b = 0; b < blockCount; b++) {
+        for (const auto& quad : cfg.blocks[b].quads) {
+            forEachUse(quad, [&](Operand temp) {
+                int g = global[dense[temp.payload()]];
+                if (g >= 0 && !defs[b].test(g)) uses[b].set(g);
+            });
+            if (definesTemp(quad) && global[dense[quad.result.payload()]] >= 0) defs[b].set(global[dense[quad.result.payload()]]);
+        }
+    }
+
+    // Backward dataflow, visiting blocks in postorder.
+    vector<int> order = cfg.reversePostorder();
+    reverse(order.begin(), order.end());
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b : order) {
+            BitSet& out = liveOut[b];
+            for (int s : cfg.blocks[b].succs) {
+                for (size_t w = 0; w < out.words.size(); w++) out.words[w] |= liveIn[s].words[w];
+            }
+            BitSet& in = liveIn[b];
+            for (size_t w = 0; w < in.words.size(); w++) {
+                uint64_t next = uses[b].words[w] | (out.words[w] & ~defs[b].words[w]);
+                if (next != in.words[w]) {
+                    in.words[w] = next;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // One interval per temp over the layout: a quad reads at an even
+    // position and writes at the odd one after it.
+    vector<int> globalTemp(globalCount);
+    for (size_t t = 0; t < original.size(); t++) {
+        if (global[t] >= 0) globalTemp[global[t]] = static_cast<int>(t);
+    }
+    vector<Interval> intervals(original.size());
+    int position = 0;
+    for (size_t b = 0; b < blockCount; b++) {
+        liveIn[b].forEach([&](size_t g) { intervals[globalTemp[g]].cover(position); });
+        position += 2;
+        for (const auto& quad : cfg.blocks[b].quads) {
+            forEachUse(quad, [&](Operand temp) { intervals[dense[temp.payload()]].cover(position); });
+            if (definesTemp(quad)) intervals[dense[quad.result.payload()]].cover(position + 1);
+            position += 2;
+        }
+        liveOut[b].forEach([&](size_t g) { intervals[globalTemp[g]].cover(position); });
+        position += 2;
+    }
+
+    // Linear scan: a number is free again once its interval has ended.
+    vector<int> byStart(original.size());
+    for (size_t t = 0; t < byStart.size(); t++) byStart[t] = static_cast<int>(t);
+    sort(byStart.begin(), byStart.end(), [&](int a, int b) { return intervals[a].start < intervals[b].start; });
+
+    vector<uint32_t> number(original.size());
+    priority_queue<pair<int, uint32_t>, vector<pair<int, uint32_t>>, greater<pair<int, uint32_t>>> active;
+    vector<uint32_t> free;
+    uint32_t used = 0;
+    for (int t : byStart) {
+        while (!active.empty() && active.top().first < intervals[t].start) {
+            free.push_back(active.top().second);
+            active.pop();
+        }
+        if (free.empty()) {
+            number[t] = used++;
+        } else {
+            number[t] = free.back();
+            free.pop_back();
+        }
+        active.push({intervals[t].end, number[t]});
+    }
+    tempsAfter = static_cast<int>(used);
+
+    auto renumber = [&](Operand& operand) {
+        if (operand.isTemp()) operand = Operand::temp(number[dense[operand.payload()]]);
+    };
+    // A copy between two temps that now share a number does nothing; SSA
+    // destruction leaves many of these once their intervals are coalesced.
+    for (auto& block : cfg.blocks) {
+        auto& quads = block.quads;
+        size_t kept = 0;
+        for (auto& quad : quads) {
+            renumber(quad.arg1);
+            renumber(quad.arg2);
+            renumber(quad.result);
+            if (quad.op == Op::Copy && quad.arg1 == quad.result) {
+                removedCopies++;
+                continue;
+            }
+            quads[kept++] = quad;
+        }
+        quads.erase(quads.begin() + kept, quads.end());
+    }
+    cfg.tempCount = used;
+    cfg.invalidateDefUse();
+}
@@ -0,0 +1,34 @@
+#ifndef TEMP_COMPACTION_HPP
+#define TEMP_COMPACTION_HPP
+
+#include <vector>
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Renumbers temps so that temps whose live ranges do not overlap
+ * share a number, leaving as few as linear scan allows. Runs on a CFG out
+ * of SSA form.
+ *
+ * Liveness is solved with bit sets, but only for temps that are read in a
+ * block before being written there. Expression temps never are, so the
+ * sets stay small however large the function grows. Each temp then gets
+ * one interval over the block layout, and a linear scan hands out numbers.
+ * Copies whose source and result end up with the same number are dropped.
+ */
+class TempCompactor {
+private:
+    int tempsBefore = 0;
+    int tempsAfter = 0;
+    int removedCopies = 0;
+
+public:
+    void run(CFG& cfg);
+
+    int getTempsBefore() const { return tempsBefore; }
+    int getTempsAfter() const { return tempsAfter; }
+    int getRemovedCopies() const { return removedCopies; }
+};
+
+#endif
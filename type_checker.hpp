@@ -6,9 +6,11 @@
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include "Utilities/token_types.hpp"
 #include "ast.hpp"
 #include "scope_analyzer.hpp"
+#include "Utilities/concurrent_symbol_table.hpp"
 
 using namespace std;
 
@@ -58,22 +60,31 @@ struct TypeInfo {
 struct FunctionSignature {
     TokenType returnType;
     vector<TokenType> paramTypes;
-    string name;
-    FunctionSignature() : returnType(T_UNKNOWN_RL), name("") {}
+    Name name;
+    bool isPure; // no global reads/writes and only calls pure functions
+    FunctionSignature() : returnType(T_UNKNOWN_RL), isPure(false) {}
     
-    FunctionSignature(string n, TokenType rt, vector<TokenType> params)
-        : name(n), returnType(rt), paramTypes(params) {}
+    FunctionSignature(Name n, TokenType rt, vector<TokenType> params)
+        : returnType(rt), paramTypes(params), name(n), isPure(false) {}
 };
 
 class TypeChecker {
 private:
     shared_ptr<Scope> currentScope;
-    unordered_map<string, FunctionSignature> functionTable;
+    ConcurrentSymbolTable<FunctionSignature> functionTable;
     TokenType currentFunctionReturnType;
     int loopDepth; 
     bool hasReturnStmt;  
+    int errorCount = 0;
+
+    // Purity tracking for the function currently being checked.
+    Name currentFunction;
+    unordered_set<Name> impureFunctions;
+    unordered_map<Name, vector<Name>> calledFunctions;
+    vector<Name> checkedFunctions;
     
     void reportError(TypeCheckError err, const string& context = "") {
+        errorCount++;
         cerr << "Type Check Error: ";
         switch (err) {
             case TypeCheckError::ErroneousVarDecl:
@@ -131,6 +142,17 @@ private:
     void pushScope() {
         currentScope = make_shared<Scope>(currentScope);
     }
+    bool isLocal(Name name) {
+        for (auto scope = currentScope; scope && !scope->globals; scope = scope->parent) {
+            if (scope->symbols.count(name)) return true;
+        }
+        return false;
+    }
+    void noteAccess(Name name) {
+        if (!currentFunction.empty() && !isLocal(name)) {
+            impureFunctions.insert(currentFunction);
+        }
+    }
     void popScope() {
         if (currentScope && currentScope->parent) {
             currentScope = currentScope->parent;
@@ -152,7 +174,8 @@ private:
                 return TypeInfo(T_BOOL_RL);
             case NODE_IDENTIFIER: {
                 auto* id = static_cast<Identifier*>(expr);
-                Symbol* sym = currentScope->lookup(id->name);
+                noteAccess(id->name);
+                const Symbol* sym = currentScope->lookup(id->name);
                 if (!sym) {
                     return TypeInfo();
                 }
@@ -251,7 +274,8 @@ private:
         return TypeInfo();
     }
     TypeInfo checkAssignment(Assignment* assign) {
-        Symbol* sym = currentScope->lookup(assign->ident);
+        noteAccess(assign->ident);
+        const Symbol* sym = currentScope->lookup(assign->ident);
         if (!sym) {
             return TypeInfo();
         }
@@ -259,27 +283,30 @@ private:
         TypeInfo valueType = checkExpression(assign->value);
         
         if (!varType.matches(valueType)) {
-            reportError(TypeCheckError::ExpressionTypeMismatch, assign->ident);
+            reportError(TypeCheckError::ExpressionTypeMismatch, assign->ident.str());
             return TypeInfo();
         }
         return varType;
     }
     
     TypeInfo checkFunctionCall(FunctionCall* call) {
-        auto it = functionTable.find(call->name);
-        if (it == functionTable.end()) {
+        if (!currentFunction.empty()) {
+            calledFunctions[currentFunction].push_back(call->name);
+        }
+        const FunctionSignature* found = functionTable.find(call->name);
+        if (!found) {
             return TypeInfo();
         }
-        FunctionSignature& sig = it->second;
+        const FunctionSignature& sig = *found;
         if (call->args.size() != sig.paramTypes.size()) {
-            reportError(TypeCheckError::FnCallParamCount, call->name);
+            reportError(TypeCheckError::FnCallParamCount, call->name.str());
             return TypeInfo();
         }
         for (size_t i = 0; i < call->args.size(); i++) {
             TypeInfo argType = checkExpression(call->args[i]);
             if (argType.type != sig.paramTypes[i]) {
                 reportError(TypeCheckError::FnCallParamType, 
-                    call->name + " at parameter " + to_string(i + 1));
+                    call->name.str() + " at parameter " + to_string(i + 1));
                 return TypeInfo();
             }
         }
@@ -344,9 +371,11 @@ private:
         if (decl->expr) {
             TypeInfo initType = checkExpression(decl->expr);
             if (initType.isValid && initType.type != decl->type) {
-                reportError(TypeCheckError::ErroneousVarDecl, decl->ident);
+                reportError(TypeCheckError::ErroneousVarDecl, decl->ident.str());
             }
         }
+        // Globals are already in the root scope; this declares locals.
+        currentScope->addSymbol(Symbol(decl->ident, decl->type));
     }
     
     void checkReturnStmt(ReturnStmt* stmt) {
@@ -421,7 +450,22 @@ public:
     }
     
     void check(vector<Stmt*>& program, shared_ptr<Scope> globalScope) {
+        registerFunctions(program, globalScope);
+        for (auto* stmt : program) {
+            if (stmt->nodeType == NODE_FUNC_DECL) {
+                auto* funcDecl = static_cast<FunctionDecl*>(stmt);
+                checkFunctionDecl(funcDecl);
+            } else {
+                checkStatement(stmt);
+            }
+        }
+        computePurity();
+    }
+    
+    // Resets the function table from the program's declarations; bodies are not visited.
+    void registerFunctions(vector<Stmt*>& program, shared_ptr<Scope> globalScope) {
         currentScope = globalScope;
+        functionTable.clear();
         for (auto* stmt : program) {
             if (stmt->nodeType == NODE_FUNC_DECL) {
                 auto* funcDecl = static_cast<FunctionDecl*>(stmt);
@@ -429,21 +473,71 @@ public:
                 for (const auto& param : funcDecl->params) {
                     paramTypes.push_back(param.type);
                 }
-                functionTable.insert({funcDecl->name, 
-                    FunctionSignature(funcDecl->name, funcDecl->returnType, paramTypes)});
+                functionTable.insert(funcDecl->name, 
+                    FunctionSignature(funcDecl->name, funcDecl->returnType, paramTypes));
             }
         }
-        for (auto* stmt : program) {
-            if (stmt->nodeType == NODE_FUNC_DECL) {
-                auto* funcDecl = static_cast<FunctionDecl*>(stmt);
-                checkFunctionDecl(funcDecl);
-            } else {
-                checkStatement(stmt);
+    }
+
+    void checkTopLevel(Stmt* stmt) {
+        checkStatement(stmt);
+    }
+
+    int getErrorCount() const { return errorCount; }
+
+    // Marks every checked function that is side-effect free, to a fixpoint
+    // over calls. Functions with type errors never count as pure.
+    void computePurity() {
+        unordered_set<Name> impure = impureFunctions;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto& entry : calledFunctions) {
+                if (impure.count(entry.first)) continue;
+                for (Name callee : entry.second) {
+                    if (impure.count(callee) || !functionTable.find(callee)) {
+                        impure.insert(entry.first);
+                        changed = true;
+                        break;
+                    }
+                }
             }
         }
+        for (Name name : checkedFunctions) {
+            const FunctionSignature* sig = functionTable.find(name);
+            if (!sig) continue;
+            FunctionSignature updated = *sig;
+            updated.isPure = !impure.count(name);
+            functionTable.assign(name, updated);
+        }
     }
-    
+
+    bool isPureFunction(Name name) const {
+        const FunctionSignature* sig = functionTable.find(name);
+        return sig && sig->isPure;
+    }
+
+    // What computePurity() knows about a checked function from its own
+    // body: whether it touches globals or failed checking, and whom it calls.
+    bool isLocallyImpure(Name name) const { return impureFunctions.count(name) > 0; }
+    vector<Name> calleesOf(Name name) const {
+        auto it = calledFunctions.find(name);
+        return it == calledFunctions.end() ? vector<Name>() : it->second;
+    }
+
+    // Feeds in those facts for a function checked by an earlier
+    // TypeChecker, so computePurity() covers it without visiting its body.
+    void restorePurity(Name name, bool locallyImpure, const vector<Name>& callees) {
+        checkedFunctions.push_back(name);
+        calledFunctions[name] = callees;
+        if (locallyImpure) impureFunctions.insert(name);
+    }
+
     void checkFunctionDecl(FunctionDecl* decl) {
+        int errorsBefore = errorCount;
+        currentFunction = decl->name;
+        checkedFunctions.push_back(decl->name);
+        calledFunctions[decl->name];
         currentFunctionReturnType = decl->returnType;
         hasReturnStmt = false;
         pushScope();
@@ -453,9 +547,11 @@ public:
         }
         checkStatement(decl->body);
         if (!hasReturnStmt) {
-            reportError(TypeCheckError::ReturnStmtNotFound, decl->name);
+            reportError(TypeCheckError::ReturnStmtNotFound, decl->name.str());
         }
         popScope();
+        if (errorCount != errorsBefore) impureFunctions.insert(decl->name);
+        currentFunction = Name();
     }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "unroll.hpp"
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
+
+namespace {
+    bool fitsInt(int64_t value) {
+        return value >= INT32_MIN && value <= INT32_MAX;
+    }
+
+    // The constant a var always holds, if its only definition copies one.
+    bool constantVar(const vector<Quad>& quads, Operand var, int64_t& value) {
+        int defs = 0;
+        for (const auto& quad : quads) {
+            if (!writesResult(quad.op) || quad.result != var) continue;
+            if (++defs > 1 || quad.op != Op::Copy || quad.arg1.kind() != OperandKind::Int) return false;
+            value = quad.arg1.intValue();
+        }
+        return defs == 1;
+    }
+
+    // The step of `iv = iv + c`, `iv = c + iv` or `iv = iv - c`.
+    bool stepOf(const Quad& quad, Operand iv, int64_t& step) {
+        if (quad.op == Op::Add && quad.arg1 == iv && quad.arg2.kind() == OperandKind::Int) step = quad.arg2.intValue();
+        else if (quad.op == Op::Add && quad.arg2 == iv && quad.arg1.kind() == OperandKind::Int) step = quad.arg1.intValue();
+        else if (quad.op == Op::Sub && quad.arg1 == iv && quad.arg2.kind() == OperandKind::Int) step = -quad.arg2.intValue();
+        else return false;
+        return true;
+    }
+
+    // Iterations of `for (i = a; i REL n; i += c)`, or -1 if the loop does
+    // not stop before i wraps around.
+    int64_t tripCountOf(Op relation, int64_t a, int64_t n, int64_t c) {
+        switch (relation) {
+            case Op::Lt: return c > 0 ? (a < n ? (n - a + c - 1) / c : 0) : -1;
+            case Op::Le: return c > 0 ? (a <= n ? (n - a) / c + 1 : 0) : -1;
+            case Op::Gt: return c < 0 ? (a > n ? (a - n - c - 1) / -c : 0) : -1;
+            case Op::Ge: return c < 0 ? (a >= n ? (a - n) / -c + 1 : 0) : -1;
+            case Op::Ne: return (n - a) % c == 0 && (n - a) / c >= 0 ? (n - a) / c : -1;
+            default: return -1;
+        }
+    }
+
+    // Appends one copy of quads[begin, end) with its own labels and temps.
+    void emitCopy(const vector<Quad>& quads, size_t begin, size_t end,
+                  uint32_t& tempCount, uint32_t& labelCount, vector<Quad>& out) {
+        unordered_map<uint32_t, Operand> renamed;
+        for (size_t i = begin; i < end; i++) {
+            const Quad& quad = quads[i];
+            if (quad.op == Op::Label) renamed[quad.result.bits] = Operand::label(labelCount++);
+            else if (writesResult(quad.op) && quad.result.isTemp() && !renamed.count(quad.result.bits))
+                renamed[quad.result.bits] = Operand::temp(tempCount++);
+        }
+        auto rename = [&](Operand operand) {
+            auto it = renamed.find(operand.bits);
+            return it == renamed.end() ? operand : it->second;
+        };
+        for (size_t i = begin; i < end; i++) {
+            const Quad& quad = quads[i];
+            out.push_back(Quad(quad.op, rename(quad.arg1), rename(quad.arg2), rename(quad.result)));
+        }
+    }
+}
+
+bool CountedLoop::analyze(const vector<Quad>& quads, size_t backEdge, CountedLoop& loop) {
+    const size_t q = backEdge;
+    if (q + 1 >= quads.size() || quads[q].op != Op::Goto) return false;
+    Operand headerLabel = quads[q].result;
+    size_t h = 0;
+    while (h < q && !(quads[h].op == Op::Label && quads[h].result == headerLabel)) h++;
+    if (h + 2 >= q) return false;
+
+    const Quad& test = quads[h + 1];
+    const Quad& branch = quads[h + 2];
+    if (!isComparison(test.op) || !test.arg1.isVar() || !test.result.isTemp()) return false;
+    if (branch.op != Op::IfFalse || branch.arg1 != test.result) return false;
+    Operand exit = branch.result;
+    if (quads[q + 1].op != Op::Label || quads[q + 1].result != exit) return false;
+
+    loop.header = h;
+    loop.backEdge = q;
+    loop.iv = test.arg1;
+    loop.relation = test.op;
+    if (test.arg2.kind() == OperandKind::Int) loop.bound = test.arg2.intValue();
+    else if (!test.arg2.isVar() || test.arg2 == loop.iv || !constantVar(quads, test.arg2, loop.bound)) return false;
+
+    // The body may branch forward within itself or to the exit, but holds
+    // no loop of its own and no continue that skips the step.
+    unordered_set<uint32_t> bodyLabels{headerLabel.bits};
+    unordered_set<uint32_t> bodyTemps{test.result.bits};
+    for (size_t i = h + 3; i < q; i++) {
+        if (quads[i].op == Op::Label) bodyLabels.insert(quads[i].result.bits);
+        else if (writesResult(quads[i].op) && quads[i].result.isTemp()) bodyTemps.insert(quads[i].result.bits);
+    }
+    size_t lastLabel = h, stepAt = 0;
+    int ivDefs = 0;
+    for (size_t i = h + 3; i < q; i++) {
+        const Quad& quad = quads[i];
+        if (quad.op == Op::Label) lastLabel = i;
+        if (quad.op == Op::Goto || quad.op == Op::IfFalse) {
+            if (quad.result == exit) continue;
+            size_t target = i + 1;
+            while (target < q && !(quads[target].op == Op::Label && quads[target].result == quad.result)) target++;
+            if (target >= q) return false;
+        }
+        if (writesResult(quad.op) && quad.result == loop.iv) {
+            ivDefs++;
+            stepAt = i;
+        }
+    }
+    if (ivDefs != 1 || stepAt < lastLabel) return false;
+
+    // Nothing outside reaches into the loop or reads its temps.
+    int testUses = 0;
+    for (size_t i = 0; i < quads.size(); i++) {
+        const Quad& quad = quads[i];
+        testUses += (quad.arg1 == test.result) + (quad.arg2 == test.result);
+        if (i >= h && i <= q) continue;
+        if (quad.op == Op::Label) continue;
+        for (Operand operand : {quad.arg1, quad.arg2, quad.result}) {
+            if (bodyTemps.count(operand.bits) || (operand.isLabel() && bodyLabels.count(operand.bits))) return false;
+        }
+    }
+    if (testUses != 1) return false;
+
+    // The step is `iv = iv + c`, or a copy of a body temp computed that way.
+    const Quad& update = quads[stepAt];
+    if (update.op == Op::Copy && update.arg1.isTemp()) {
+        int defs = 0;
+        for (size_t i = h + 3; i < q; i++) {
+            if (!writesResult(quads[i].op) || quads[i].result != update.arg1) continue;
+            if (++defs > 1 || i > stepAt || !stepOf(quads[i], loop.iv, loop.step)) return false;
+        }
+        if (defs != 1) return false;
+    } else if (!stepOf(update, loop.iv, loop.step)) {
+        return false;
+    }
+
+    // The starting value is a constant copied in on the way into the header.
+    bool found = false;
+    for (size_t i = h; i-- > 0 && !found;) {
+        const Quad& quad = quads[i];
+        if (quad.op == Op::Label || quad.op == Op::Goto || quad.op == Op::IfFalse || quad.op == Op::Return) return false;
+        if (!writesResult(quad.op) || quad.result != loop.iv) continue;
+        if (quad.op != Op::Copy || quad.arg1.kind() != OperandKind::Int) return false;
+        loop.init = quad.arg1.intValue();
+        found = true;
+    }
+    if (!found || loop.step == 0) return false;
+    if (!fitsInt(loop.init) || !fitsInt(loop.bound) || !fitsInt(loop.step)) return false;
+
+    loop.tripCount = tripCountOf(loop.relation, loop.init, loop.bound, loop.step);
+    return loop.tripCount >= 0 && fitsInt(loop.init + loop.tripCount * loop.step);
+}
+
+void LoopUnroller::run(TACProgram& program) {
+    for (auto& function : program.functions) {
+        unordered_set<uint32_t> done;
+        while (unrollOne(function, done)) {}
+    }
+}
+
+bool LoopUnroller::unrollOne(TACFunction& function, unordered_set<uint32_t>& done) {
+    const auto& quads = function.quads;
+    bool profiled = profile && profile->covers(function.name);
+    vector<uint64_t> counts;
+    if (profiled) counts = profile->quadCounts(function);
+
+    for (size_t q = 0; q < quads.size(); q++) {
+        CountedLoop loop;
+        if (quads[q].op != Op::Goto || done.count(quads[q].result.bits)) continue;
+        if (!CountedLoop::analyze(quads, q, loop)) continue;
+
+        const size_t h = loop.header, bodyStart = h + 3;
+        int64_t cost = 0;
+        for (size_t i = bodyStart; i < q; i++) cost += quads[i].op != Op::Label;
+
+        int64_t budget = sizeBudget;
+        if (profiled && profile->isHot(counts[h])) budget *= 2;
+        bool full = loop.tripCount <= maxFullCount && loop.tripCount * cost <= budget;
+        int64_t k = factor;
+        while (k > 1 && k * cost > budget) k--;
+        int64_t shortBound = loop.bound - (k - 1) * loop.step;
+        bool partial = !full && loop.relation != Op::Ne && k > 1 && loop.tripCount >= 2 * k && fitsInt(shortBound);
+        if ((!full && !partial) || (profiled && counts[h] == 0)) {
+            done.insert(quads[q].result.bits);
+            continue;
+        }
+
+        uint32_t tempCount = 0, labelCount = 0;
+        for (const auto& quad : quads) {
+            for (Operand operand : {quad.arg1, quad.arg2, quad.result}) {
+                if (operand.isTemp()) tempCount = max(tempCount, operand.payload() + 1);
+                if (operand.isLabel()) labelCount = max(labelCount, operand.payload() + 1);
+            }
+        }
+
+        vector<Quad> out(quads.begin(), quads.begin() + h);
+        if (full) {
+            for (int64_t n = 0; n < loop.tripCount; n++) emitCopy(quads, bodyStart, q, tempCount, labelCount, out);
+            out.insert(out.end(), quads.begin() + q + 1, quads.end());
+            fullyUnrolledCount++;
+        } else {
+            // k iterations per test while k more are sure to run; the
+            // original loop then does the rest.
+            Operand top = Operand::label(labelCount++);
+            Operand test = Operand::temp(tempCount++);
+            Operand header = quads[h].result;
+            out.push_back(Quad(Op::Label, Operand(), Operand(), top));
+            out.push_back(Quad(loop.relation, loop.iv, Operand::intConst(shortBound), test));
+            // The guard shares the header's profile site, if it has one.
+            out.push_back(Quad(Op::IfFalse, test, quads[h + 2].arg2, header));
+            for (int64_t n = 0; n < k; n++) emitCopy(quads, bodyStart, q, tempCount, labelCount, out);
+            out.push_back(Quad(Op::Goto, Operand(), Operand(), top));
+            out.insert(out.end(), quads.begin() + h, quads.end());
+            done.insert(top.bits);
+            done.insert(header.bits);
+            partiallyUnrolledCount++;
+        }
+        function.quads = move(out);
+        return true;
+    }
+    return false;
+}
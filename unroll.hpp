@@ -0,0 +1,63 @@
+#ifndef UNROLL_HPP
+#define UNROLL_HPP
+
+#include <vector>
+#include <unordered_set>
+#include "tac.hpp"
+#include "profile.hpp"
+
+using namespace std;
+
+/**
+ * @brief A loop in the layout the IR generator gives while and for loops,
+ * `Lh: t = i REL n; if_false t goto Le; body; goto Lh; Le:`, whose trip
+ * count is known: i starts at a constant, changes by a constant step once
+ * per iteration, and is tested against a constant bound. Indices point
+ * into the function's quads.
+ */
+struct CountedLoop {
+    size_t header;   // Label Lh
+    size_t backEdge; // goto Lh; the body is header + 3 .. backEdge - 1
+    Operand iv;
+    Op relation;
+    int64_t init = 0;
+    int64_t step = 0;
+    int64_t bound = 0;
+    int64_t tripCount = 0;
+
+    // Recognizes the innermost loop closed by the goto at `backEdge`.
+    static bool analyze(const vector<Quad>& quads, size_t backEdge, CountedLoop& loop);
+};
+
+/**
+ * @brief Unrolls counted innermost loops in TAC before SSA. A loop whose
+ * body fits `sizeBudget` quads `tripCount` times, with at most
+ * `maxFullCount` iterations, is replaced by that many copies of its body.
+ * Otherwise, if `factor` copies fit, an unrolled loop that tests once per
+ * `factor` iterations runs first and the original loop finishes the
+ * remaining ones. Each copy gets its own labels and temps. With a profile,
+ * loops that never ran are left alone and hot ones get twice the budget.
+ */
+class LoopUnroller {
+private:
+    int sizeBudget;
+    int maxFullCount;
+    int factor;
+    int fullyUnrolledCount = 0;
+    int partiallyUnrolledCount = 0;
+    const EdgeProfile* profile = nullptr;
+
+    bool unrollOne(TACFunction& function, unordered_set<uint32_t>& done);
+
+public:
+    explicit LoopUnroller(int sizeBudget = 64, int maxFullCount = 16, int factor = 4)
+        : sizeBudget(sizeBudget), maxFullCount(maxFullCount), factor(factor) {}
+
+    void setProfile(const EdgeProfile* edgeProfile) { profile = edgeProfile; }
+    void run(TACProgram& program);
+
+    int getFullyUnrolledCount() const { return fullyUnrolledCount; }
+    int getPartiallyUnrolledCount() const { return partiallyUnrolledCount; }
+};
+
+#endif
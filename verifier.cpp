@@ -0,0 +1,122 @@
+#include "verifier.hpp"
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    [[noreturn]] void fail(const string& where, const string& problem) {
+        throw runtime_error(where + ": " + problem);
+    }
+
+    bool isJump(Op op) {
+        return op == Op::Goto || op == Op::IfFalse;
+    }
+
+    void verifyFunction(const TACFunction& function, const unordered_map<uint32_t, int>& paramCounts) {
+        const string where = "function " + function.name.str();
+        unordered_set<uint32_t> labels, written;
+        for (const auto& quad : function.quads) {
+            if (quad.op == Op::Label && !labels.insert(quad.result.bits).second) {
+                fail(where, "label " + quad.result.toString() + " defined twice");
+            }
+            if (writesResult(quad.op) && quad.result.isTemp()) written.insert(quad.result.bits);
+        }
+
+        int pendingArgs = 0;
+        for (const auto& quad : function.quads) {
+            if (isJump(quad.op) && !labels.count(quad.result.bits)) {
+                fail(where, "jump to undefined label in '" + quad.toString() + "'");
+            }
+            for (Operand arg : {quad.arg1, quad.arg2}) {
+                if (arg.isTemp() && !written.count(arg.bits)) fail(where, arg.toString() + " is read but never written");
+            }
+            if ((quad.op == Op::Load && quad.arg1.kind() != OperandKind::Global) || (quad.op == Op::Store && quad.result.kind() != OperandKind::Global)) {
+                fail(where, "memory access without a global in '" + quad.toString() + "'");
+            }
+
+            if (quad.op == Op::Arg) {
+                pendingArgs++;
+            } else if (isCall(quad.op)) {
+                auto callee = paramCounts.find(quad.arg1.payload());
+                if (quad.arg1.kind() != OperandKind::Func || callee == paramCounts.end()) fail(where, "call to unknown function in '" + quad.toString() + "'");
+                if (quad.arg2.intValue() != pendingArgs || pendingArgs != callee->second) {
+                    fail(where, "argument count mismatch in '" + quad.toString() + "'");
+                }
+                pendingArgs = 0;
+            } else if (pendingArgs && quad.op == Op::Label) {
+                fail(where, "arguments left pending at " + quad.result.toString());
+            }
+        }
+    }
+}
+
+void verifyProgram(const TACProgram& program) {
+    unordered_map<uint32_t, int> paramCounts;
+    for (const auto& function : program.functions) {
+        if (!paramCounts.insert({function.name.id, function.paramCount}).second) {
+            fail("program", "function " + function.name.str() + " defined twice");
+        }
+    }
+    for (const auto& function : program.functions) verifyFunction(function, paramCounts);
+}
+
+void verifyCFG(CFG& cfg, bool ssa) {
+    for (const auto& block : cfg.blocks) {
+        const string where = "block " + to_string(block.id);
+        if (block.id == 0 && !block.preds.empty()) fail(where, "entry block has predecessors");
+        for (int s : block.succs) {
+            const auto& preds = cfg.blocks[s].preds;
+            if (find(preds.begin(), preds.end(), block.id) == preds.end()) fail(where, "successor " + to_string(s) + " does not list it");
+        }
+        for (int p : block.preds) {
+            const auto& succs = cfg.blocks[p].succs;
+            if (find(succs.begin(), succs.end(), block.id) == succs.end()) fail(where, "predecessor " + to_string(p) + " does not list it");
+        }
+        for (size_t i = 0; i < block.quads.size(); i++) {
+            const Quad& quad = block.quads[i];
+            if (quad.op == Op::Label) fail(where, "label quad inside the block");
+            bool ends = isJump(quad.op) || quad.op == Op::Return;
+            if (ends && i + 1 != block.quads.size()) fail(where, "'" + quad.toString() + "' is not the last quad");
+            if (isJump(quad.op) && cfg.blockForLabel(quad.result) < 0) fail(where, "jump to a label no block has");
+        }
+        if (!ssa && !block.phis.empty()) fail(where, "phi outside SSA form");
+        for (const auto& phi : block.phis) {
+            if (phi.args.size() != block.preds.size()) fail(where, "'" + phi.toString() + "' does not match the predecessors");
+        }
+    }
+    if (!ssa) return;
+
+    // Each temp has one definition, and it dominates every use: a phi
+    // argument is used at the end of its predecessor.
+    const DefUseIndex& chains = cfg.defUse();
+    auto check = [&](Operand value, const Site& use) {
+        if (!value.isTemp()) return;
+        const auto& defs = chains.definitionsOf(value);
+        const string where = "block " + to_string(use.block);
+        if (defs.size() != 1) fail(where, value.toString() + " has " + to_string(defs.size()) + " definitions");
+        const Site& def = defs[0];
+        if (!cfg.isReachable(use.block) || !cfg.isReachable(def.block)) return;
+        bool dominated = def.block == use.block ? def.index < use.index : cfg.dominates(def.block, use.block);
+        if (!dominated) fail(where, "use of " + value.toString() + " is not dominated by its definition");
+    };
+    for (const auto& block : cfg.blocks) {
+        for (const auto& phi : block.phis) {
+            for (size_t i = 0; i < phi.args.size(); i++) {
+                int pred = block.preds[i];
+                check(phi.args[i], Site{pred, static_cast<int>(cfg.blocks[pred].quads.size())});
+            }
+        }
+        for (size_t i = 0; i < block.quads.size(); i++) {
+            const Quad& quad = block.quads[i];
+            Site here{block.id, static_cast<int>(i)};
+            check(quad.arg1, here);
+            check(quad.arg2, here);
+            if (writesResult(quad.op) && quad.result.isTemp() && chains.definitionsOf(quad.result).size() != 1) {
+                fail("block " + to_string(block.id), quad.result.toString() + " is defined more than once");
+            }
+        }
+        for (const auto& phi : block.phis) {
+            if (chains.definitionsOf(phi.result).size() != 1) fail("block " + to_string(block.id), phi.result.toString() + " is defined more than once");
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef VERIFIER_HPP
+#define VERIFIER_HPP
+
+#include "tac.hpp"
+#include "cfg.hpp"
+
+using namespace std;
+
+/**
+ * @brief Consistency checks for the IR between passes. Each throws
+ * runtime_error describing the first problem it finds.
+ *
+ * verifyProgram checks linear TAC: unique function names and labels, jumps
+ * to labels that exist, calls to functions of the program with their
+ * declared argument count, and temps that are written somewhere in the
+ * function that reads them. verifyCFG checks edges, block shape and, in
+ * SSA form, that every temp has one definition which dominates each of
+ * its uses.
+ */
+void verifyProgram(const TACProgram& program);
+void verifyCFG(CFG& cfg, bool ssa);
+
+#endif